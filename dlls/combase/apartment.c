@@ -708,6 +708,29 @@ struct host_object_params
     BOOL apartment_threaded; /* is the component purely apartment-threaded? */
 };
 
+/* Strips quotes from, or expands environment variables in, a registered dll path. */
+static BOOL get_dll_path_from_value(WCHAR *src, DWORD keytype, WCHAR *dst, DWORD dstlen)
+{
+    if (keytype == REG_EXPAND_SZ)
+        return dstlen > ExpandEnvironmentStringsW(src, dst, dstlen);
+    else
+    {
+        const WCHAR *quote_start;
+        quote_start = wcschr(src, '\"');
+        if (quote_start)
+        {
+            const WCHAR *quote_end = wcschr(quote_start + 1, '\"');
+            if (quote_end)
+            {
+                memmove(src, quote_start + 1, (quote_end - quote_start - 1) * sizeof(WCHAR));
+                src[quote_end - quote_start - 1] = '\0';
+            }
+        }
+        lstrcpynW(dst, src, dstlen);
+        return TRUE;
+    }
+}
+
 /* Returns expanded dll path from the registry or activation context. */
 static BOOL get_object_dll_path(const struct class_reg_data *regdata, WCHAR *dst, DWORD dstlen)
 {
@@ -720,28 +743,15 @@ static BOOL get_object_dll_path(const struct class_reg_data *regdata, WCHAR *dst
         DWORD dwLength = dstlen * sizeof(WCHAR);
 
         if ((ret = RegQueryValueExW(regdata->u.hkey, NULL, NULL, &keytype, (BYTE*)src, &dwLength)) == ERROR_SUCCESS)
-        {
-            if (keytype == REG_EXPAND_SZ)
-            {
-                if (dstlen <= ExpandEnvironmentStringsW(src, dst, dstlen)) ret = ERROR_MORE_DATA;
-            }
-            else
-            {
-                const WCHAR *quote_start;
-                quote_start = wcschr(src, '\"');
-                if (quote_start)
-                {
-                    const WCHAR *quote_end = wcschr(quote_start + 1, '\"');
-                    if (quote_end)
-                    {
-                        memmove(src, quote_start + 1, (quote_end - quote_start - 1) * sizeof(WCHAR));
-                        src[quote_end - quote_start - 1] = '\0';
-                    }
-                }
-                lstrcpynW(dst, src, dstlen);
-            }
-        }
-        return !ret;
+            return get_dll_path_from_value(src, keytype, dst, dstlen);
+        return FALSE;
+    }
+    else if (regdata->origin == CLASS_REG_CACHE)
+    {
+        WCHAR src[MAX_PATH];
+
+        lstrcpynW(src, regdata->u.cache->path, ARRAY_SIZE(src));
+        return get_dll_path_from_value(src, regdata->u.cache->path_type, dst, dstlen);
     }
     else
     {
@@ -1003,31 +1013,49 @@ static HRESULT apartment_hostobject_in_hostapt(struct apartment *apt, BOOL multi
     return hr;
 }
 
-static enum comclass_threadingmodel get_threading_model(const struct class_reg_data *data)
+static enum comclass_threadingmodel query_threading_model(HKEY hkey)
 {
-    if (data->origin == CLASS_REG_REGISTRY)
-    {
-        WCHAR threading_model[10 /* lstrlenW(L"apartment")+1 */];
-        DWORD dwLength = sizeof(threading_model);
-        DWORD keytype;
-        DWORD ret;
+    WCHAR threading_model[10 /* lstrlenW(L"apartment")+1 */];
+    DWORD dwLength = sizeof(threading_model);
+    DWORD keytype;
+    DWORD ret;
 
-        ret = RegQueryValueExW(data->u.hkey, L"ThreadingModel", NULL, &keytype, (BYTE*)threading_model, &dwLength);
-        if ((ret != ERROR_SUCCESS) || (keytype != REG_SZ))
-            threading_model[0] = '\0';
+    ret = RegQueryValueExW(hkey, L"ThreadingModel", NULL, &keytype, (BYTE*)threading_model, &dwLength);
+    if ((ret != ERROR_SUCCESS) || (keytype != REG_SZ))
+        threading_model[0] = '\0';
 
-        if (!wcsicmp(threading_model, L"Apartment")) return ThreadingModel_Apartment;
-        if (!wcsicmp(threading_model, L"Free")) return ThreadingModel_Free;
-        if (!wcsicmp(threading_model, L"Both")) return ThreadingModel_Both;
+    if (!wcsicmp(threading_model, L"Apartment")) return ThreadingModel_Apartment;
+    if (!wcsicmp(threading_model, L"Free")) return ThreadingModel_Free;
+    if (!wcsicmp(threading_model, L"Both")) return ThreadingModel_Both;
 
-        /* there's not specific handling for this case */
-        if (threading_model[0]) return ThreadingModel_Neutral;
-        return ThreadingModel_No;
-    }
+    /* there's not specific handling for this case */
+    if (threading_model[0]) return ThreadingModel_Neutral;
+    return ThreadingModel_No;
+}
+
+static enum comclass_threadingmodel get_threading_model(const struct class_reg_data *data)
+{
+    if (data->origin == CLASS_REG_REGISTRY)
+        return query_threading_model(data->u.hkey);
+    else if (data->origin == CLASS_REG_CACHE)
+        return data->u.cache->threading_model;
     else
         return data->u.actctx.threading_model;
 }
 
+/* Reads the values of an InprocServer32 or InprocHandler32 key that are needed
+ * to activate the class, so that they can be cached by the caller. */
+BOOL read_class_reg_cache_data(HKEY hkey, struct class_reg_cache_data *data)
+{
+    DWORD len = sizeof(data->path) - sizeof(WCHAR);
+
+    if (RegQueryValueExW(hkey, NULL, NULL, &data->path_type, (BYTE *)data->path, &len))
+        return FALSE;
+    data->path[len / sizeof(WCHAR)] = 0;
+    data->threading_model = query_threading_model(hkey);
+    return TRUE;
+}
+
 HRESULT apartment_get_inproc_class_object(struct apartment *apt, const struct class_reg_data *regdata,
         REFCLSID rclsid, REFIID riid, DWORD class_context, void **ppv)
 {
@@ -1695,6 +1695,243 @@ HRESULT WINAPI CoCreateInstanceFromApp(REFCLSID rclsid, IUnknown *outer, DWORD c
             count, results);
 }
 
+/* Per-process cache of class registrations read from HKCR\\CLSID, so that
+ * repeated activations of the same class don't have to query the registry.
+ * The cache is flushed whenever anything under the CLSID key changes. */
+enum class_cache_kind
+{
+    CLASS_CACHE_TREATAS,
+    CLASS_CACHE_INPROC_SERVER,
+    CLASS_CACHE_INPROC_HANDLER,
+};
+
+union class_cache_value
+{
+    CLSID treat_as;
+    struct class_reg_cache_data regdata;
+};
+
+struct class_cache_entry
+{
+    struct list entry;
+    CLSID clsid;
+    enum class_cache_kind kind;
+    union class_cache_value value;
+};
+
+#define CLASS_CACHE_MAX_ENTRIES 256
+
+static struct list class_cache = LIST_INIT(class_cache);
+static unsigned int class_cache_count;
+static LONG class_cache_generation;
+static BOOL class_cache_initialized;
+static HKEY class_cache_key;
+static HANDLE class_cache_event;
+static TP_WAIT *class_cache_wait;
+
+static CRITICAL_SECTION class_cache_cs;
+static CRITICAL_SECTION_DEBUG class_cache_cs_debug =
+{
+    0, 0, &class_cache_cs,
+    { &class_cache_cs_debug.ProcessLocksList, &class_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": class_cache_cs") }
+};
+static CRITICAL_SECTION class_cache_cs = { &class_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static void class_cache_flush(void)
+{
+    struct class_cache_entry *cur, *cur2;
+
+    LIST_FOR_EACH_ENTRY_SAFE(cur, cur2, &class_cache, struct class_cache_entry, entry)
+    {
+        list_remove(&cur->entry);
+        free(cur);
+    }
+    class_cache_count = 0;
+    class_cache_generation++;
+}
+
+static BOOL class_cache_watch(void)
+{
+    if (RegNotifyChangeKeyValue(class_cache_key, TRUE, REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET,
+            class_cache_event, TRUE))
+        return FALSE;
+    SetThreadpoolWait(class_cache_wait, class_cache_event, NULL);
+    return TRUE;
+}
+
+static void CALLBACK class_cache_changed(TP_CALLBACK_INSTANCE *instance, void *context, TP_WAIT *wait,
+        TP_WAIT_RESULT result)
+{
+    EnterCriticalSection(&class_cache_cs);
+    TRACE("class registrations changed, flushing %u cache entries\n", class_cache_count);
+    /* rearm first, so that a change racing with the flush isn't lost */
+    if (!class_cache_watch())
+    {
+        WARN("failed to watch class registrations, disabling cache\n");
+        RegCloseKey(class_cache_key);
+        class_cache_key = NULL;
+    }
+    class_cache_flush();
+    LeaveCriticalSection(&class_cache_cs);
+}
+
+/* called with class_cache_cs held */
+static BOOL class_cache_init(void)
+{
+    if (class_cache_initialized) return !!class_cache_key;
+    class_cache_initialized = TRUE;
+
+    if (open_classes_key(HKEY_CLASSES_ROOT, L"CLSID", KEY_NOTIFY, &class_cache_key))
+        return FALSE;
+    if ((class_cache_event = CreateEventW(NULL, FALSE, FALSE, NULL))
+            && (class_cache_wait = CreateThreadpoolWait(class_cache_changed, NULL, NULL))
+            && class_cache_watch())
+        return TRUE;
+
+    WARN("failed to watch class registrations, disabling cache\n");
+    RegCloseKey(class_cache_key);
+    class_cache_key = NULL;
+    return FALSE;
+}
+
+static void class_cache_cleanup(void)
+{
+    if (class_cache_wait)
+    {
+        SetThreadpoolWait(class_cache_wait, NULL, NULL);
+        WaitForThreadpoolWaitCallbacks(class_cache_wait, TRUE);
+        CloseThreadpoolWait(class_cache_wait);
+    }
+    if (class_cache_event) CloseHandle(class_cache_event);
+    if (class_cache_key) RegCloseKey(class_cache_key);
+    class_cache_flush();
+    DeleteCriticalSection(&class_cache_cs);
+}
+
+/* On a miss, returns the generation that has to be passed to class_cache_add(),
+ * so that values read concurrently with a registry change aren't cached. */
+static BOOL class_cache_lookup(REFCLSID clsid, enum class_cache_kind kind, union class_cache_value *value,
+        LONG *generation)
+{
+    struct class_cache_entry *cur;
+    BOOL ret = FALSE;
+
+    EnterCriticalSection(&class_cache_cs);
+    *generation = class_cache_init() ? class_cache_generation : -1;
+    LIST_FOR_EACH_ENTRY(cur, &class_cache, struct class_cache_entry, entry)
+    {
+        if (cur->kind != kind || !IsEqualCLSID(&cur->clsid, clsid)) continue;
+        /* keep recently used entries at the head */
+        list_remove(&cur->entry);
+        list_add_head(&class_cache, &cur->entry);
+        *value = cur->value;
+        ret = TRUE;
+        break;
+    }
+    LeaveCriticalSection(&class_cache_cs);
+    return ret;
+}
+
+static void class_cache_add(REFCLSID clsid, enum class_cache_kind kind, const union class_cache_value *value,
+        LONG generation)
+{
+    struct class_cache_entry *entry;
+
+    if (generation == -1) return;
+
+    EnterCriticalSection(&class_cache_cs);
+    if (generation == class_cache_generation)
+    {
+        if (class_cache_count == CLASS_CACHE_MAX_ENTRIES)
+        {
+            entry = LIST_ENTRY(list_tail(&class_cache), struct class_cache_entry, entry);
+            list_remove(&entry->entry);
+        }
+        else if ((entry = malloc(sizeof(*entry))))
+            class_cache_count++;
+
+        if (entry)
+        {
+            entry->clsid = *clsid;
+            entry->kind = kind;
+            entry->value = *value;
+            list_add_head(&class_cache, &entry->entry);
+        }
+    }
+    LeaveCriticalSection(&class_cache_cs);
+}
+
+/* Same as CoGetTreatAsClass(), but goes through the class cache. Like native,
+ * CoCreateInstance() may thus see TreatAs changes only after a short delay. */
+static void get_treat_as_class(REFCLSID clsid, CLSID *treat_as)
+{
+    union class_cache_value value;
+    LONG generation;
+
+    if (class_cache_lookup(clsid, CLASS_CACHE_TREATAS, &value, &generation))
+    {
+        *treat_as = value.treat_as;
+        return;
+    }
+
+    if (FAILED(CoGetTreatAsClass(clsid, treat_as)))
+        return;
+
+    value.treat_as = *treat_as;
+    class_cache_add(clsid, CLASS_CACHE_TREATAS, &value, generation);
+}
+
+static HRESULT get_registry_class_object(struct apartment *apt, REFCLSID rclsid, enum class_cache_kind kind,
+        REFIID riid, DWORD clscontext, void **obj)
+{
+    struct class_reg_data clsreg = { 0 };
+    union class_cache_value value;
+    LONG generation;
+    HKEY hkey;
+    HRESULT hr;
+
+    if (class_cache_lookup(rclsid, kind, &value, &generation))
+    {
+        clsreg.u.cache = &value.regdata;
+        clsreg.origin = CLASS_REG_CACHE;
+        return apartment_get_inproc_class_object(apt, &clsreg, rclsid, riid, clscontext, obj);
+    }
+
+    hr = open_key_for_clsid(rclsid, kind == CLASS_CACHE_INPROC_SERVER ? L"InprocServer32" : L"InprocHandler32",
+            KEY_READ, &hkey);
+    if (FAILED(hr))
+    {
+        if (hr == REGDB_E_CLASSNOTREG)
+            ERR("class %s not registered\n", debugstr_guid(rclsid));
+        else if (hr == REGDB_E_KEYMISSING)
+        {
+            if (kind == CLASS_CACHE_INPROC_SERVER)
+                WARN("class %s not registered as in-proc server\n", debugstr_guid(rclsid));
+            else
+                WARN("class %s not registered in-proc handler\n", debugstr_guid(rclsid));
+            hr = REGDB_E_CLASSNOTREG;
+        }
+        return hr;
+    }
+
+    if (read_class_reg_cache_data(hkey, &value.regdata))
+    {
+        class_cache_add(rclsid, kind, &value, generation);
+        clsreg.u.cache = &value.regdata;
+        clsreg.origin = CLASS_REG_CACHE;
+    }
+    else
+    {
+        clsreg.u.hkey = hkey;
+        clsreg.origin = CLASS_REG_REGISTRY;
+    }
+
+    hr = apartment_get_inproc_class_object(apt, &clsreg, rclsid, riid, clscontext, obj);
+    RegCloseKey(hkey);
+    return hr;
+}
+
 static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
         COSERVERINFO *server_info, REFIID riid, void **obj)
 {
@@ -1771,28 +2008,7 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
     /* First try in-process server */
     if (clscontext & CLSCTX_INPROC_SERVER)
     {
-        HKEY hkey;
-
-        hr = open_key_for_clsid(rclsid, L"InprocServer32", KEY_READ, &hkey);
-        if (FAILED(hr))
-        {
-            if (hr == REGDB_E_CLASSNOTREG)
-                ERR("class %s not registered\n", debugstr_guid(rclsid));
-            else if (hr == REGDB_E_KEYMISSING)
-            {
-                WARN("class %s not registered as in-proc server\n", debugstr_guid(rclsid));
-                hr = REGDB_E_CLASSNOTREG;
-            }
-        }
-
-        if (SUCCEEDED(hr))
-        {
-            clsreg.u.hkey = hkey;
-            clsreg.origin = CLASS_REG_REGISTRY;
-
-            hr = apartment_get_inproc_class_object(apt, &clsreg, rclsid, riid, clscontext, obj);
-            RegCloseKey(hkey);
-        }
+        hr = get_registry_class_object(apt, rclsid, CLASS_CACHE_INPROC_SERVER, riid, clscontext, obj);
 
         /* return if we got a class, otherwise fall through to one of the
          * other types */
@@ -1806,28 +2022,7 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
     /* Next try in-process handler */
     if (clscontext & CLSCTX_INPROC_HANDLER)
     {
-        HKEY hkey;
-
-        hr = open_key_for_clsid(rclsid, L"InprocHandler32", KEY_READ, &hkey);
-        if (FAILED(hr))
-        {
-            if (hr == REGDB_E_CLASSNOTREG)
-                ERR("class %s not registered\n", debugstr_guid(rclsid));
-            else if (hr == REGDB_E_KEYMISSING)
-            {
-                WARN("class %s not registered in-proc handler\n", debugstr_guid(rclsid));
-                hr = REGDB_E_CLASSNOTREG;
-            }
-        }
-
-        if (SUCCEEDED(hr))
-        {
-            clsreg.u.hkey = hkey;
-            clsreg.origin = CLASS_REG_REGISTRY;
-
-            hr = apartment_get_inproc_class_object(apt, &clsreg, rclsid, riid, clscontext, obj);
-            RegCloseKey(hkey);
-        }
+        hr = get_registry_class_object(apt, rclsid, CLASS_CACHE_INPROC_HANDLER, riid, clscontext, obj);
 
         /* return if we got a class, otherwise fall through to one of the
          * other types */
@@ -1883,7 +2078,7 @@ HRESULT WINAPI DECLSPEC_HOTPATCH CoCreateInstanceEx(REFCLSID rclsid, IUnknown *o
 
     clsid = *rclsid;
     if (!(cls_context & CLSCTX_APPCONTAINER))
-        CoGetTreatAsClass(rclsid, &clsid);
+        get_treat_as_class(rclsid, &clsid);
 
     if (FAILED(hr = com_get_class_object(&clsid, cls_context, NULL, &IID_IClassFactory, (void **)&factory)))
         return hr;
@@ -3377,6 +3572,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD reason, LPVOID reserved)
         if (reserved) break;
         apartment_global_cleanup();
         DeleteCriticalSection(&registered_classes_cs);
+        class_cache_cleanup();
         rpc_unregister_channel_hooks();
         break;
     case DLL_THREAD_DETACH:
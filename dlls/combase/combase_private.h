@@ -139,6 +139,14 @@ enum class_reg_data_origin
 {
     CLASS_REG_ACTCTX,
     CLASS_REG_REGISTRY,
+    CLASS_REG_CACHE,
+};
+
+struct class_reg_cache_data
+{
+    DWORD threading_model;
+    DWORD path_type;
+    WCHAR path[MAX_PATH];
 };
 
 struct class_reg_data
@@ -153,6 +161,7 @@ struct class_reg_data
             HANDLE hactctx;
         } actctx;
         HKEY hkey;
+        const struct class_reg_cache_data *cache;
     } u;
 };
 
@@ -166,6 +175,7 @@ HRESULT ensure_mta(void);
 struct apartment * apartment_get_mta(void);
 HRESULT apartment_get_inproc_class_object(struct apartment *apt, const struct class_reg_data *regdata,
         REFCLSID rclsid, REFIID riid, DWORD class_context, void **ppv);
+BOOL read_class_reg_cache_data(HKEY hkey, struct class_reg_cache_data *data);
 HRESULT apartment_get_local_server_stream(struct apartment *apt, IStream **ret);
 IUnknown *com_get_registered_class_object(const struct apartment *apartment, REFCLSID rclsid,
         DWORD clscontext);
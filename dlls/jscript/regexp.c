@@ -2529,6 +2529,68 @@ SimpleMatch(REGlobalData *gData, match_state_t *x, REOp op,
     return NULL;
 }
 
+/*
+ * Advance x->cp to the first position at which the leading literal or class
+ * at pc can match, so that anchoring doesn't have to go through SimpleMatch
+ * for every character of the input. Returns FALSE, with x->cp moved to the
+ * end of input, if no such position exists.
+ */
+static BOOL
+SkipToFirstChar(REGlobalData *gData, match_state_t *x, REOp op, jsbytecode *pc)
+{
+    const WCHAR *cp = x->cp, *end = gData->cpend;
+    size_t offset, length, index;
+    RECharSet *charSet;
+    WCHAR matchCh;
+
+    switch (op) {
+      case REOP_FLAT:
+        pc = ReadCompactIndex(pc, &offset);
+        ReadCompactIndex(pc, &length);
+        if (length > (size_t)(end - cp)) {
+            cp = NULL;
+            break;
+        }
+        matchCh = gData->regexp->source[offset];
+        cp = wmemchr(cp, matchCh, end - cp - (length - 1));
+        break;
+      case REOP_FLAT1:
+        matchCh = *pc;
+        cp = wmemchr(cp, matchCh, end - cp);
+        break;
+      case REOP_UCFLAT1:
+        matchCh = GET_ARG(pc);
+        cp = wmemchr(cp, matchCh, end - cp);
+        break;
+      case REOP_CLASS:
+        ReadCompactIndex(pc, &index);
+        assert(index < gData->regexp->classCount);
+        charSet = &gData->regexp->classList[index];
+        assert(charSet->converted);
+        if (!charSet->length) {
+            cp = NULL;
+            break;
+        }
+        while (cp < end && (*cp > charSet->length ||
+               !(charSet->u.bits[*cp >> 3] & (1 << (*cp & 0x7)))))
+            cp++;
+        if (cp == end)
+            cp = NULL;
+        break;
+      default:
+        return TRUE;
+    }
+
+    if (!cp) {
+        gData->skipped += end - x->cp;
+        x->cp = end;
+        return FALSE;
+    }
+    gData->skipped += cp - x->cp;
+    x->cp = cp;
+    return TRUE;
+}
+
 static inline match_state_t *
 ExecuteREBytecode(REGlobalData *gData, match_state_t *x)
 {
@@ -2556,6 +2618,8 @@ ExecuteREBytecode(REGlobalData *gData, match_state_t *x)
     if (REOP_IS_SIMPLE(op) && !(gData->regexp->flags & REG_STICKY)) {
         anchor = FALSE;
         while (x->cp <= gData->cpend) {
+            if (!SkipToFirstChar(gData, x, op, pc))
+                break;
             nextpc = pc;    /* reset back to start each time */
             result = SimpleMatch(gData, x, op, &nextpc, TRUE);
             if (result) {
@@ -732,4 +732,27 @@ ok(re.ignoreCase === false, "re.ignoreCase = " + re.ignoreCase);
 ok(re.multiline === true, "re.multiline = " + re.multiline);
 ok(re.global === true, "re.global = " + re.global);
 
+var long_str = "";
+for(i = 0; i < 1000; i++)
+    long_str += "abcdefghij";
+
+m = /\u0100/.exec(long_str + "\u0100");
+ok(m.index === 10000, "m.index = " + m.index);
+m = /jab/.exec(long_str);
+ok(m.index === 9, "m.index = " + m.index);
+m = /jak/.exec(long_str);
+ok(m === null, "m = " + m);
+m = /[xyj]/.exec(long_str);
+ok(m.index === 9, "m.index = " + m.index);
+m = /[xyz]/.exec(long_str + "z");
+ok(m.index === 10000, "m.index = " + m.index);
+m = /i/.exec(long_str.substr(0, 5));
+ok(m === null, "m = " + m);
+r = long_str.replace(/c/g, "");
+ok(r.length === 9000, "r.length = " + r.length);
+r = long_str.replace("ija", "-");
+ok(r.substr(0, 10) === "abcdefgh-b", "r.substr(0, 10) = " + r.substr(0, 10));
+r = long_str.split("j");
+ok(r.length === 1001, "r.length = " + r.length);
+
 reportSuccess();
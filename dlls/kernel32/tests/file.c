@@ -5519,10 +5519,10 @@ static void test_GetFileAttributesExW(void)
 static void test_post_completion(void)
 {
     OVERLAPPED ovl, ovl2, *povl;
-    OVERLAPPED_ENTRY entries[2];
+    OVERLAPPED_ENTRY entries[2], batch[150];
     ULONG_PTR key;
     HANDLE port;
-    ULONG count;
+    ULONG count, i;
     DWORD size;
     BOOL ret;
 
@@ -5621,6 +5621,33 @@ static void test_post_completion(void)
 
     SleepEx(0, TRUE);
 
+    for (i = 0; i < 200; i++)
+    {
+        ret = PostQueuedCompletionStatus( port, i, i + 1, &ovl );
+        ok(ret, "PostQueuedCompletionStatus failed: %lu\n", GetLastError());
+    }
+
+    count = 0xdeadbeef;
+    ret = pGetQueuedCompletionStatusEx( port, batch, 120, &count, 0, FALSE );
+    ok(ret, "GetQueuedCompletionStatusEx failed\n");
+    ok(count == 120, "wrong count %lu\n", count);
+    for (i = 0; i < count; i++)
+    {
+        ok(batch[i].lpCompletionKey == i + 1, "%lu: wrong key %Iu\n", i, batch[i].lpCompletionKey);
+        ok(batch[i].dwNumberOfBytesTransferred == i, "%lu: wrong size %lu\n", i, batch[i].dwNumberOfBytesTransferred);
+    }
+
+    count = 0xdeadbeef;
+    ret = pGetQueuedCompletionStatusEx( port, batch, ARRAY_SIZE(batch), &count, 0, FALSE );
+    ok(ret, "GetQueuedCompletionStatusEx failed\n");
+    ok(count == 80, "wrong count %lu\n", count);
+    for (i = 0; i < count; i++)
+        ok(batch[i].lpCompletionKey == i + 121, "%lu: wrong key %Iu\n", i, batch[i].lpCompletionKey);
+
+    ret = GetQueuedCompletionStatus( port, &size, &key, &povl, 0 );
+    ok(!ret, "GetQueuedCompletionStatus succeeded\n");
+    ok(GetLastError() == WAIT_TIMEOUT, "wrong error %lu\n", GetLastError());
+
     CloseHandle( port );
 }
 
@@ -5633,8 +5660,9 @@ static void test_overlapped_read(void)
     char temp_path[MAX_PATH];
     char file_name[MAX_PATH];
     DWORD bytes_count;
-    OVERLAPPED ov;
-    HANDLE hfile;
+    OVERLAPPED ov, *povl;
+    HANDLE hfile, port;
+    ULONG_PTR key;
     DWORD err;
     DWORD ret;
 
@@ -5683,7 +5711,32 @@ static void test_overlapped_read(void)
     }
     ok(!bytes_count, "Unexpected read size %lu.\n", bytes_count);
 
+    ov.Offset = 0;
+    ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    ret = ReadFile(hfile, buffer, TEST_OVERLAPPED_READ_SIZE, NULL, &ov);
+    ok(!ret && GetLastError() == ERROR_IO_PENDING,
+            "Unexpected ReadFile result, ret %#lx, GetLastError() %lu.\n", ret, GetLastError());
+    ret = WaitForSingleObject(ov.hEvent, 1000);
+    ok(!ret, "Unexpected wait result %#lx.\n", ret);
+
+    port = CreateIoCompletionPort(hfile, NULL, 1, 0);
+    ok(!!port, "Unexpected error %lu.\n", GetLastError());
+    ResetEvent(ov.hEvent);
+    ret = ReadFile(hfile, buffer, TEST_OVERLAPPED_READ_SIZE, NULL, &ov);
+    ok(!ret && GetLastError() == ERROR_IO_PENDING,
+            "Unexpected ReadFile result, ret %#lx, GetLastError() %lu.\n", ret, GetLastError());
+    ret = WaitForSingleObject(ov.hEvent, 1000);
+    ok(!ret, "Unexpected wait result %#lx.\n", ret);
+    bytes_count = 0;
+    ret = GetQueuedCompletionStatus(port, &bytes_count, &key, &povl, 1000);
+    ok(ret, "Unexpected error %lu.\n", GetLastError());
+    ok(bytes_count == TEST_OVERLAPPED_READ_SIZE, "Unexpected read size %lu.\n", bytes_count);
+    ok(key == 1, "Unexpected key %Iu.\n", key);
+    ok(povl == &ov, "Unexpected overlapped %p.\n", povl);
+
+    CloseHandle(ov.hEvent);
     CloseHandle(hfile);
+    CloseHandle(port);
     ret = DeleteFileA(file_name);
     ok(ret, "Unexpected error %lu.\n", GetLastError());
 }
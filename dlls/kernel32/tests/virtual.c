@@ -2138,6 +2138,42 @@ static void test_write_watch(void)
     if (count) ok( results[0] == base + 5*pagesize, "wrong result %p\n", results[0] );
 
     VirtualFree( base, 0, MEM_RELEASE );
+
+    /* sparse writes in a larger region, reset in several steps */
+
+    size = 0x400000;
+    base = VirtualAlloc( 0, size, MEM_RESERVE | MEM_COMMIT | MEM_WRITE_WATCH, PAGE_READWRITE );
+    ok( base != NULL, "VirtualAlloc failed %lu\n", GetLastError() );
+
+    for (i = 0; i < size; i += 64 * pagesize) base[i + 7] = 1;
+
+    count = 4;
+    ret = pGetWriteWatch( WRITE_WATCH_FLAG_RESET, base, size, results, &count, &pagesize );
+    ok( !ret, "GetWriteWatch failed %lu\n", GetLastError() );
+    ok( count == 4, "wrong count %Iu\n", count );
+    ok( results[3] == base + 3 * 64 * pagesize, "wrong result %p\n", results[3] );
+
+    count = 64;
+    ret = pGetWriteWatch( WRITE_WATCH_FLAG_RESET, base, size, results, &count, &pagesize );
+    ok( !ret, "GetWriteWatch failed %lu\n", GetLastError() );
+    ok( count == size / (64 * pagesize) - 4, "wrong count %Iu\n", count );
+    for (i = 0; i < count; i++) if (results[i] != base + (i + 4) * 64 * pagesize) break;
+    ok( i == count, "wrong result %p at %lu\n", results[i], i );
+
+    count = 64;
+    ret = pGetWriteWatch( 0, base, size, results, &count, &pagesize );
+    ok( !ret, "GetWriteWatch failed %lu\n", GetLastError() );
+    ok( count == 0, "wrong count %Iu\n", count );
+
+    base[size - 1] = 2;
+
+    count = 64;
+    ret = pGetWriteWatch( 0, base, size, results, &count, &pagesize );
+    ok( !ret, "GetWriteWatch failed %lu\n", GetLastError() );
+    ok( count == 1, "wrong count %Iu\n", count );
+    ok( results[0] == base + size - pagesize, "wrong result %p\n", results[0] );
+
+    VirtualFree( base, 0, MEM_RELEASE );
 }
 
 #if defined(__i386__) || defined(__x86_64__)
@@ -4218,6 +4254,51 @@ static void test_shared_memory_ro(BOOL is_child, DWORD child_access)
     CloseHandle(mapping);
 }
 
+static void test_large_pages(void)
+{
+    MEMORY_BASIC_INFORMATION info;
+    SIZE_T size = GetLargePageMinimum();
+    char *base;
+    BOOL ret;
+
+    if (!size)
+    {
+        skip( "large pages not supported\n" );
+        return;
+    }
+    ok( !(size & (size - 1)), "wrong large page minimum %Ix\n", size );
+
+    SetLastError( 0xdeadbeef );
+    base = VirtualAlloc( NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+    if (!base && GetLastError() == ERROR_PRIVILEGE_NOT_HELD)
+    {
+        skip( "SeLockMemoryPrivilege not held\n" );
+        return;
+    }
+    ok( base != NULL, "VirtualAlloc failed %lu\n", GetLastError() );
+    ok( !((UINT_PTR)base & (size - 1)), "unaligned large page allocation %p\n", base );
+    base[0] = 1;
+    base[size - 1] = 2;
+    ret = VirtualQuery( base, &info, sizeof(info) );
+    ok( ret, "VirtualQuery failed %lu\n", GetLastError() );
+    ok( info.RegionSize == size, "wrong RegionSize 0x%Ix\n", info.RegionSize );
+    ok( info.State == MEM_COMMIT, "wrong State 0x%lx\n", info.State );
+    ok( info.Protect == PAGE_READWRITE, "wrong Protect 0x%lx\n", info.Protect );
+    ok( info.Type == MEM_PRIVATE, "wrong Type 0x%lx\n", info.Type );
+    ret = VirtualFree( base, 0, MEM_RELEASE );
+    ok( ret, "VirtualFree failed %lu\n", GetLastError() );
+
+    SetLastError( 0xdeadbeef );
+    base = VirtualAlloc( NULL, size, MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE );
+    ok( !base, "VirtualAlloc succeeded\n" );
+    ok( GetLastError() == ERROR_INVALID_PARAMETER, "wrong error %lu\n", GetLastError() );
+
+    SetLastError( 0xdeadbeef );
+    base = VirtualAlloc( NULL, size / 2, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+    ok( !base, "VirtualAlloc succeeded\n" );
+    ok( GetLastError() == ERROR_INVALID_PARAMETER, "wrong error %lu\n", GetLastError() );
+}
+
 static void test_PrefetchVirtualMemory(void)
 {
     WIN32_MEMORY_RANGE_ENTRY entries[2];
@@ -4341,6 +4422,7 @@ START_TEST(virtual)
     test_IsBadCodePtr();
     test_write_watch();
     test_PrefetchVirtualMemory();
+    test_large_pages();
 #if defined(__i386__) || defined(__x86_64__)
     test_stack_commit();
 #endif
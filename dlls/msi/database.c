@@ -275,6 +275,7 @@ UINT MSI_OpenDatabaseW(LPCWSTR szDBPath, LPCWSTR szPersist, MSIDATABASE **pdb)
         db->deletefile = wcsdup( szDBPath );
     list_init( &db->tables );
     list_init( &db->transforms );
+    list_init( &db->query_cache );
 
     db->strings = msi_load_string_table( stg, &db->bytes_per_strref );
     if( !db->strings )
@@ -104,6 +104,31 @@ static void CDECL cabinet_free(void *pv)
     free(pv);
 }
 
+/* file handed to FDI, either a cabinet or an extracted file */
+struct cabinet_file
+{
+    HANDLE                 handle;  /* file handle, NULL for a cabinet stream */
+    IStream               *stream;  /* cabinet stream */
+    struct cabinet_writer *writer;  /* writer thread for extracted files, if any */
+};
+
+static INT_PTR alloc_cabinet_file( HANDLE handle, IStream *stream, struct cabinet_writer *writer )
+{
+    struct cabinet_file *file;
+
+    if (handle == INVALID_HANDLE_VALUE) return -1;
+    if (!(file = malloc( sizeof(*file) )))
+    {
+        if (handle) CloseHandle( handle );
+        if (stream) IStream_Release( stream );
+        return -1;
+    }
+    file->handle = handle;
+    file->stream = stream;
+    file->writer = writer;
+    return (INT_PTR)file;
+}
+
 static INT_PTR CDECL cabinet_open(char *pszFile, int oflag, int pmode)
 {
     DWORD dwAccess = 0;
@@ -136,26 +161,220 @@ static INT_PTR CDECL cabinet_open(char *pszFile, int oflag, int pmode)
     path = strdupUtoW(pszFile);
     handle = CreateFileW(path, dwAccess, dwShareMode, NULL, dwCreateDisposition, 0, NULL);
     free(path);
-    return (INT_PTR)handle;
+    return alloc_cabinet_file(handle, NULL, NULL);
 }
 
 static UINT CDECL cabinet_read(INT_PTR hf, void *pv, UINT cb)
 {
-    HANDLE handle = (HANDLE)hf;
+    struct cabinet_file *file = (struct cabinet_file *)hf;
     DWORD read;
 
-    if (ReadFile(handle, pv, cb, &read, NULL))
+    if (ReadFile(file->handle, pv, cb, &read, NULL))
         return read;
 
     return 0;
 }
 
+/*
+ * Extracted files are written on a separate thread so that decompression of
+ * the next block can proceed while the previous one is being written out.
+ * Output files are still created on the installer thread. A failed write is
+ * only reported to FDI by the next write or close, which stops extraction
+ * there; msi_cabextract() then fails even if FDI had already finished.
+ */
+#define MAX_PENDING_WRITE (4 * 1024 * 1024)
+
+struct write_request
+{
+    struct list entry;
+    HANDLE      handle;
+    BOOL        close;
+    BOOL        set_time;
+    FILETIME    time;
+    UINT        size;
+    BYTE        data[1];
+};
+
+struct cabinet_writer
+{
+    CRITICAL_SECTION   cs;
+    CONDITION_VARIABLE queued;
+    CONDITION_VARIABLE completed;
+    struct list        requests;
+    SIZE_T             pending;
+    UINT               busy;
+    BOOL               shutdown;
+    DWORD              error;
+    HANDLE             thread;
+};
+
+static DWORD process_write_request( struct write_request *req )
+{
+    DWORD written, err = ERROR_SUCCESS;
+
+    if (!req->close)
+    {
+        if (!WriteFile( req->handle, req->data, req->size, &written, NULL )) err = GetLastError();
+        else if (written != req->size) err = ERROR_WRITE_FAULT;
+        return err;
+    }
+    if (req->set_time && !SetFileTime( req->handle, &req->time, 0, &req->time )) err = GetLastError();
+    CloseHandle( req->handle );
+    return err;
+}
+
+static DWORD WINAPI cabinet_writer_thread( void *arg )
+{
+    struct cabinet_writer *writer = arg;
+    struct write_request *req;
+    DWORD err;
+
+    EnterCriticalSection( &writer->cs );
+    for (;;)
+    {
+        while (list_empty( &writer->requests ) && !writer->shutdown)
+            SleepConditionVariableCS( &writer->queued, &writer->cs, INFINITE );
+        if (list_empty( &writer->requests )) break;
+
+        req = LIST_ENTRY( list_head( &writer->requests ), struct write_request, entry );
+        list_remove( &req->entry );
+        LeaveCriticalSection( &writer->cs );
+
+        err = process_write_request( req );
+
+        EnterCriticalSection( &writer->cs );
+        if (err && !writer->error)
+        {
+            WARN( "write failed (error %lu)\n", err );
+            writer->error = err;
+        }
+        writer->pending -= req->size;
+        writer->busy--;
+        free( req );
+        WakeAllConditionVariable( &writer->completed );
+    }
+    LeaveCriticalSection( &writer->cs );
+    return 0;
+}
+
+static struct cabinet_writer *start_cabinet_writer( void )
+{
+    struct cabinet_writer *writer;
+
+    if (!(writer = calloc( 1, sizeof(*writer) ))) return NULL;
+
+    InitializeCriticalSection( &writer->cs );
+    InitializeConditionVariable( &writer->queued );
+    InitializeConditionVariable( &writer->completed );
+    list_init( &writer->requests );
+
+    if (!(writer->thread = CreateThread( NULL, 0, cabinet_writer_thread, writer, 0, NULL )))
+    {
+        WARN( "failed to create writer thread, writing synchronously\n" );
+        DeleteCriticalSection( &writer->cs );
+        free( writer );
+        return NULL;
+    }
+    return writer;
+}
+
+static DWORD stop_cabinet_writer( struct cabinet_writer *writer )
+{
+    DWORD err;
+
+    if (!writer) return ERROR_SUCCESS;
+
+    EnterCriticalSection( &writer->cs );
+    writer->shutdown = TRUE;
+    WakeAllConditionVariable( &writer->queued );
+    LeaveCriticalSection( &writer->cs );
+
+    WaitForSingleObject( writer->thread, INFINITE );
+    CloseHandle( writer->thread );
+
+    err = writer->error;
+    DeleteCriticalSection( &writer->cs );
+    free( writer );
+    return err;
+}
+
+static void flush_cabinet_writer( struct cabinet_writer *writer )
+{
+    if (!writer) return;
+
+    EnterCriticalSection( &writer->cs );
+    while (writer->busy) SleepConditionVariableCS( &writer->completed, &writer->cs, INFINITE );
+    LeaveCriticalSection( &writer->cs );
+}
+
+/* returns FALSE once a previous request has failed, the handle is still closed */
+static BOOL queue_write_request( struct cabinet_writer *writer, struct write_request *req )
+{
+    BOOL ret;
+
+    EnterCriticalSection( &writer->cs );
+    while (writer->busy && writer->pending + req->size > MAX_PENDING_WRITE)
+        SleepConditionVariableCS( &writer->completed, &writer->cs, INFINITE );
+
+    ret = !writer->error;
+    if (!ret && !req->close)
+    {
+        LeaveCriticalSection( &writer->cs );
+        free( req );
+        return FALSE;
+    }
+    list_add_tail( &writer->requests, &req->entry );
+    writer->pending += req->size;
+    writer->busy++;
+    WakeConditionVariable( &writer->queued );
+    LeaveCriticalSection( &writer->cs );
+    return ret;
+}
+
+static BOOL close_output_file( struct cabinet_file *file, const FILETIME *time )
+{
+    struct cabinet_writer *writer = file->writer;
+    HANDLE handle = file->handle;
+    struct write_request *req;
+    BOOL ret = TRUE;
+
+    free( file );
+    if (writer && (req = calloc( 1, sizeof(*req) )))
+    {
+        req->handle = handle;
+        req->close = TRUE;
+        if (time)
+        {
+            req->set_time = TRUE;
+            req->time = *time;
+        }
+        return queue_write_request( writer, req );
+    }
+
+    flush_cabinet_writer( writer );
+    if (time) ret = SetFileTime( handle, time, 0, time );
+    CloseHandle( handle );
+    return ret;
+}
+
 static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 {
-    HANDLE handle = (HANDLE)hf;
+    struct cabinet_file *file = (struct cabinet_file *)hf;
+    struct write_request *req;
     DWORD written;
 
-    if (WriteFile(handle, pv, cb, &written, NULL))
+    if (file->writer && (req = malloc( offsetof( struct write_request, data[cb] ) )))
+    {
+        req->handle = file->handle;
+        req->close = FALSE;
+        req->set_time = FALSE;
+        req->size = cb;
+        memcpy( req->data, pv, cb );
+        return queue_write_request( file->writer, req ) ? cb : 0;
+    }
+
+    flush_cabinet_writer( file->writer );
+    if (WriteFile(file->handle, pv, cb, &written, NULL))
         return written;
 
     return 0;
@@ -163,15 +382,22 @@ static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 
 static int CDECL cabinet_close(INT_PTR hf)
 {
-    HANDLE handle = (HANDLE)hf;
-    return CloseHandle(handle) ? 0 : -1;
+    struct cabinet_file *file = (struct cabinet_file *)hf;
+    int ret = 0;
+
+    /* make sure no queued writes refer to the handle */
+    flush_cabinet_writer( file->writer );
+    if (file->stream) IStream_Release( file->stream );
+    else if (!CloseHandle( file->handle )) ret = -1;
+    free( file );
+    return ret;
 }
 
 static LONG CDECL cabinet_seek(INT_PTR hf, LONG dist, int seektype)
 {
-    HANDLE handle = (HANDLE)hf;
+    struct cabinet_file *file = (struct cabinet_file *)hf;
     /* flags are compatible and so are passed straight through */
-    return SetFilePointer(handle, dist, NULL, seektype);
+    return SetFilePointer(file->handle, dist, NULL, seektype);
 }
 
 struct package_disk
@@ -219,38 +445,31 @@ static INT_PTR CDECL cabinet_open_stream( char *pszFile, int oflag, int pmode )
             return -1;
         }
     }
-    return (INT_PTR)stream;
+    return alloc_cabinet_file( NULL, stream, NULL );
 }
 
 static UINT CDECL cabinet_read_stream( INT_PTR hf, void *pv, UINT cb )
 {
-    IStream *stm = (IStream *)hf;
+    struct cabinet_file *file = (struct cabinet_file *)hf;
     DWORD read;
     HRESULT hr;
 
-    hr = IStream_Read( stm, pv, cb, &read );
+    hr = IStream_Read( file->stream, pv, cb, &read );
     if (hr == S_OK || hr == S_FALSE)
         return read;
 
     return 0;
 }
 
-static int CDECL cabinet_close_stream( INT_PTR hf )
-{
-    IStream *stm = (IStream *)hf;
-    IStream_Release( stm );
-    return 0;
-}
-
 static LONG CDECL cabinet_seek_stream( INT_PTR hf, LONG dist, int seektype )
 {
-    IStream *stm = (IStream *)hf;
+    struct cabinet_file *file = (struct cabinet_file *)hf;
     LARGE_INTEGER move;
     ULARGE_INTEGER newpos;
     HRESULT hr;
 
     move.QuadPart = dist;
-    hr = IStream_Seek( stm, move, seektype, &newpos );
+    hr = IStream_Seek( file->stream, move, seektype, &newpos );
     if (SUCCEEDED(hr))
     {
         if (newpos.QuadPart <= MAXLONG) return newpos.QuadPart;
@@ -480,7 +699,8 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
 done:
     free(path);
 
-    return (INT_PTR)handle;
+    if (!handle) return 0;
+    return alloc_cabinet_file( handle, NULL, data->writer );
 }
 
 static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
@@ -489,27 +709,23 @@ static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
     MSICABDATA *data = pfdin->pv;
     FILETIME ft;
     FILETIME ftLocal;
-    HANDLE handle = (HANDLE)pfdin->hf;
+    struct cabinet_file *file = (struct cabinet_file *)pfdin->hf;
 
     data->mi->is_continuous = FALSE;
 
     if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft))
     {
-        CloseHandle(handle);
+        close_output_file(file, NULL);
         return -1;
     }
     if (!LocalFileTimeToFileTime(&ft, &ftLocal))
     {
-        CloseHandle(handle);
+        close_output_file(file, NULL);
         return -1;
     }
-    if (!SetFileTime(handle, &ftLocal, 0, &ftLocal))
-    {
-        CloseHandle(handle);
+    if (!close_output_file(file, &ftLocal))
         return -1;
-    }
 
-    CloseHandle(handle);
     data->cb(data->package, data->curfile, MSICABEXTRACT_FILEEXTRACTED, NULL, NULL, data->user);
 
     free(data->curfile);
@@ -614,7 +830,7 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
     TRACE("extracting %s disk id %u\n", debugstr_w(mi->cabinet), mi->disk_id);
 
     hfdi = FDICreate( cabinet_alloc, cabinet_free, cabinet_open_stream, cabinet_read_stream,
-                      cabinet_write, cabinet_close_stream, cabinet_seek_stream, 0, &erf );
+                      cabinet_write, cabinet_close, cabinet_seek_stream, 0, &erf );
     if (!hfdi)
     {
         ERR("FDICreate failed\n");
@@ -639,11 +855,26 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
  */
 BOOL msi_cabextract(MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data)
 {
+    MSICABDATA *cab_data = data;
+    DWORD err;
+    BOOL ret;
+
+    cab_data->writer = start_cabinet_writer();
+
     if (mi->cabinet[0] == '#')
+        ret = extract_cabinet_stream( package, mi, data );
+    else
+        ret = extract_cabinet( package, mi, data );
+
+    err = stop_cabinet_writer( cab_data->writer );
+    cab_data->writer = NULL;
+    if (err && ret)
     {
-        return extract_cabinet_stream( package, mi, data );
+        ERR( "failed to write extracted files (error %lu)\n", err );
+        mi->is_extracted = FALSE;
+        ret = FALSE;
     }
-    return extract_cabinet( package, mi, data );
+    return ret;
 }
 
 void msi_free_media_info(MSIMEDIAINFO *mi)
@@ -120,6 +120,11 @@ typedef struct tagMSIDATABASE
     MSISTREAM *streams;
     UINT num_streams;
     UINT num_streams_allocated;
+    struct list query_cache;
+    UINT query_cache_size;
+    BOOL cache_queries;
+    UINT query_compile_count;
+    UINT query_execute_count;
 } MSIDATABASE;
 
 typedef struct tagMSIVIEW MSIVIEW;
@@ -131,6 +136,7 @@ typedef struct tagMSIQUERY
     UINT row;
     MSIDATABASE *db;
     struct list mem;
+    WCHAR *text;
 } MSIQUERY;
 
 /* maybe we can use a Variant instead of doing it ourselves? */
@@ -866,6 +872,9 @@ typedef UINT (*record_func)( MSIRECORD *, LPVOID );
 extern UINT MSI_IterateRecords( MSIQUERY *, LPDWORD, record_func, LPVOID );
 extern MSIRECORD * WINAPIV MSI_QueryGetRecord( MSIDATABASE *db, LPCWSTR query, ... );
 extern UINT MSI_DatabaseGetPrimaryKeys( MSIDATABASE *, LPCWSTR, MSIRECORD ** );
+extern void msi_enable_query_cache( MSIDATABASE * );
+extern void msi_disable_query_cache( MSIDATABASE * );
+extern void msi_free_cached_queries( MSIDATABASE * );
 
 /* view internals */
 extern UINT MSI_ViewExecute( MSIQUERY*, MSIRECORD * );
@@ -1107,6 +1116,7 @@ typedef struct
     PMSICABEXTRACTCB cb;
     LPWSTR curfile;
     PVOID user;
+    struct cabinet_writer *writer;
 } MSICABDATA;
 
 extern UINT ready_media(MSIPACKAGE *package, BOOL compressed, MSIMEDIAINFO *mi);
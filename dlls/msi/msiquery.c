@@ -41,21 +41,136 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(msi);
 
-static void MSI_CloseView( MSIOBJECTHDR *arg )
+/* Views of SELECT queries are kept in a per database cache when they are
+ * closed, so that opening the same query again doesn't have to parse it.
+ * Cached views reference the database, so the cache is only enabled while
+ * a package owns the database. */
+struct cached_query
+{
+    struct list entry;
+    WCHAR *text;
+    MSIVIEW *view;
+    struct list mem;
+};
+
+#define MAX_CACHED_QUERIES 64
+
+static void free_query_view( MSIVIEW *view, struct list *mem )
 {
-    MSIQUERY *query = (MSIQUERY*) arg;
     struct list *ptr, *t;
 
-    if( query->view && query->view->ops->delete )
-        query->view->ops->delete( query->view );
-    msiobj_release( &query->db->hdr );
+    if( view && view->ops->delete )
+        view->ops->delete( view );
 
-    LIST_FOR_EACH_SAFE( ptr, t, &query->mem )
+    LIST_FOR_EACH_SAFE( ptr, t, mem )
     {
         free( ptr );
     }
 }
 
+static void free_cached_query( struct cached_query *cached )
+{
+    free_query_view( cached->view, &cached->mem );
+    free( cached->text );
+    free( cached );
+}
+
+/* called when the schema changes, cached views may refer to freed tables */
+void msi_free_cached_queries( MSIDATABASE *db )
+{
+    while (!list_empty( &db->query_cache ))
+    {
+        struct cached_query *cached = LIST_ENTRY( list_head( &db->query_cache ), struct cached_query, entry );
+
+        list_remove( &cached->entry );
+        free_cached_query( cached );
+    }
+    db->query_cache_size = 0;
+}
+
+void msi_enable_query_cache( MSIDATABASE *db )
+{
+    db->cache_queries = TRUE;
+}
+
+void msi_disable_query_cache( MSIDATABASE *db )
+{
+    TRACE( "%p: %u queries compiled, %u executed\n", db, db->query_compile_count, db->query_execute_count );
+
+    db->cache_queries = FALSE;
+    msi_free_cached_queries( db );
+}
+
+static BOOL is_cacheable_query( const WCHAR *text )
+{
+    while (iswspace( *text )) text++;
+    if (wcsnicmp( text, L"SELECT", 6 )) return FALSE;
+
+    /* these views take a snapshot of the storage when they are created */
+    return !wcsstr( text, L"_Streams" ) && !wcsstr( text, L"_Storages" );
+}
+
+static BOOL get_cached_query( MSIQUERY *query, const WCHAR *text )
+{
+    MSIDATABASE *db = query->db;
+    struct cached_query *cached;
+
+    LIST_FOR_EACH_ENTRY( cached, &db->query_cache, struct cached_query, entry )
+    {
+        if (wcscmp( cached->text, text )) continue;
+
+        list_remove( &cached->entry );
+        db->query_cache_size--;
+
+        query->view = cached->view;
+        query->view->error = MSIDBERROR_NOERROR;
+        query->view->error_column = NULL;
+        list_move_tail( &query->mem, &cached->mem );
+        query->text = cached->text;
+        free( cached );
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static BOOL cache_query( MSIQUERY *query )
+{
+    MSIDATABASE *db = query->db;
+    struct cached_query *cached;
+
+    if (!db->cache_queries || !query->text || !query->view) return FALSE;
+    if (!(cached = malloc( sizeof(*cached) ))) return FALSE;
+
+    if (query->view->ops->close) query->view->ops->close( query->view );
+
+    cached->text = query->text;
+    cached->view = query->view;
+    list_init( &cached->mem );
+    list_move_tail( &cached->mem, &query->mem );
+    list_add_head( &db->query_cache, &cached->entry );
+
+    if (++db->query_cache_size > MAX_CACHED_QUERIES)
+    {
+        cached = LIST_ENTRY( list_tail( &db->query_cache ), struct cached_query, entry );
+        list_remove( &cached->entry );
+        db->query_cache_size--;
+        free_cached_query( cached );
+    }
+    return TRUE;
+}
+
+static void MSI_CloseView( MSIOBJECTHDR *arg )
+{
+    MSIQUERY *query = (MSIQUERY*) arg;
+
+    if (!cache_query( query ))
+    {
+        free_query_view( query->view, &query->mem );
+        free( query->text );
+    }
+    msiobj_release( &query->db->hdr );
+}
+
 UINT VIEW_find_column( MSIVIEW *table, LPCWSTR name, LPCWSTR table_name, UINT *n )
 {
     LPCWSTR col_name, haystack_table_name;
@@ -124,7 +239,17 @@ UINT MSI_DatabaseOpenViewW( MSIDATABASE *db, const WCHAR *szQuery, MSIQUERY **pV
     query->db = db;
     list_init( &query->mem );
 
-    r = MSI_ParseSQL( db, szQuery, &query->view, &query->mem );
+    if (db->cache_queries && szQuery && is_cacheable_query( szQuery ) &&
+        !get_cached_query( query, szQuery ))
+        query->text = wcsdup( szQuery );
+
+    if (query->view)
+        r = ERROR_SUCCESS;
+    else
+    {
+        r = MSI_ParseSQL( db, szQuery, &query->view, &query->mem );
+        db->query_compile_count++;
+    }
     if( r == ERROR_SUCCESS )
     {
         msiobj_addref( &query->hdr );
@@ -511,6 +636,7 @@ UINT MSI_ViewExecute(MSIQUERY *query, MSIRECORD *rec )
     if( !view->ops->execute )
         return ERROR_FUNCTION_FAILED;
     query->row = 0;
+    query->db->query_execute_count++;
 
     return view->ops->execute( view, rec );
 }
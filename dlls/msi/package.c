@@ -337,6 +337,7 @@ static void MSI_FreePackage( MSIOBJECTHDR *arg)
     if( package->dialog )
         msi_dialog_destroy( package->dialog );
 
+    msi_disable_query_cache( package->db );
     msiobj_release( &package->db->hdr );
     free_package_structures(package);
     CloseHandle( package->log_file );
@@ -980,6 +981,7 @@ MSIPACKAGE *MSI_CreatePackage( MSIDATABASE *db )
     {
         msiobj_addref( &db->hdr );
         package->db = db;
+        msi_enable_query_cache( db );
 
         package->LastAction = NULL;
         package->LastActionTemplate = NULL;
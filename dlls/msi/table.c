@@ -57,6 +57,24 @@ struct column_info
     struct column_hash_entry **hash_table;
 };
 
+/* Primary key index of a table. Each bucket holds a chain of the rows whose
+ * key columns hash to it. Chains link row ids rather than row numbers, so that
+ * inserting or deleting a row doesn't renumber them; ids are stored as id + 1,
+ * 0 ends a chain. The row of each id is only recomputed when a lookup needs it. */
+struct key_index
+{
+    UINT  bucket_count;
+    UINT *buckets;
+    UINT  size;         /* allocated size of the arrays below */
+    UINT  id_count;     /* number of ids in use or in the free list */
+    UINT  free_id;      /* head of the list of free ids, chained through next */
+    UINT *next;         /* next id in chain, by id */
+    UINT *hash;         /* full key hash, by id */
+    UINT *id_row;       /* row number, by id */
+    UINT *row_id;       /* id, by row number */
+    BOOL  id_row_valid;
+};
+
 struct tagMSITABLE
 {
     BYTE **data;
@@ -65,6 +83,7 @@ struct tagMSITABLE
     struct list entry;
     struct column_info *colinfo;
     UINT col_count;
+    struct key_index *key_index;
     MSICONDITION persistent;
     LONG ref_count;
     WCHAR name[1];
@@ -361,6 +380,18 @@ static void free_colinfo( struct column_info *colinfo, UINT count )
     for (i = 0; i < count; i++) free( colinfo[i].hash_table );
 }
 
+static void free_key_index( MSITABLE *table )
+{
+    if (!table->key_index) return;
+    free( table->key_index->buckets );
+    free( table->key_index->next );
+    free( table->key_index->hash );
+    free( table->key_index->id_row );
+    free( table->key_index->row_id );
+    free( table->key_index );
+    table->key_index = NULL;
+}
+
 static void free_table( MSITABLE *table )
 {
     UINT i;
@@ -368,6 +399,7 @@ static void free_table( MSITABLE *table )
         free( table->data[i] );
     free( table->data );
     free( table->data_persistent );
+    free_key_index( table );
     free_colinfo( table->colinfo, table->col_count );
     free( table->colinfo );
     free( table );
@@ -595,6 +627,7 @@ static UINT get_table( MSIDATABASE *db, LPCWSTR name, MSITABLE **table_ret )
     table->data_persistent = NULL;
     table->colinfo = NULL;
     table->col_count = 0;
+    table->key_index = NULL;
     table->persistent = MSICONDITION_TRUE;
     lstrcpyW( table->name, name );
 
@@ -725,12 +758,16 @@ UINT msi_create_table( MSIDATABASE *db, LPCWSTR name, column_info *col_info,
     if( !table )
         return ERROR_FUNCTION_FAILED;
 
+    /* cached views may refer to an empty table of that name */
+    msi_free_cached_queries( db );
+
     table->ref_count = 0;
     table->row_count = 0;
     table->data = NULL;
     table->data_persistent = NULL;
     table->colinfo = NULL;
     table->col_count = 0;
+    table->key_index = NULL;
     table->persistent = persistent;
     lstrcpyW( table->name, name );
 
@@ -939,7 +976,9 @@ static void update_table_columns( MSIDATABASE *db, const WCHAR *name )
     UINT n;
 
     if (!(table = find_cached_table( db, name ))) return;
+    msi_free_cached_queries( db );
     old_count = table->col_count;
+    free_key_index( table );
     free_colinfo( table->colinfo, table->col_count );
     free( table->colinfo );
     table->colinfo = NULL;
@@ -1155,10 +1194,180 @@ static UINT TABLE_fetch_stream( struct tagMSIVIEW *view, UINT row, UINT col, ISt
     return r;
 }
 
+static inline UINT hash_key_value( UINT hash, UINT value )
+{
+    return (hash ^ value) * 0x01000193;
+}
+
+static UINT hash_row_key( struct table_view *tv, UINT row )
+{
+    UINT i, x, hash = 0x811c9dc5;
+
+    for (i = 0; i < tv->num_cols; i++)
+    {
+        if (!(tv->columns[i].type & MSITYPE_KEY)) continue;
+        if (TABLE_fetch_int( &tv->view, row, i + 1, &x )) x = 0;
+        hash = hash_key_value( hash, x );
+    }
+    return hash;
+}
+
+static UINT hash_record_key( const struct table_view *tv, const UINT *data )
+{
+    UINT i, hash = 0x811c9dc5;
+
+    for (i = 0; i < tv->num_cols; i++)
+    {
+        if (!(tv->columns[i].type & MSITYPE_KEY)) continue;
+        hash = hash_key_value( hash, data[i] );
+    }
+    return hash;
+}
+
+static void key_index_add( struct table_view *tv, UINT row )
+{
+    struct key_index *index = tv->table->key_index;
+    UINT id, *bucket;
+
+    if (!index) return;
+    id = index->row_id[row];
+    index->hash[id] = hash_row_key( tv, row );
+    bucket = &index->buckets[index->hash[id] & (index->bucket_count - 1)];
+    index->next[id] = *bucket;
+    *bucket = id + 1;
+}
+
+static void key_index_remove( struct table_view *tv, UINT row )
+{
+    struct key_index *index = tv->table->key_index;
+    UINT id, *entry;
+
+    if (!index) return;
+    id = index->row_id[row];
+    entry = &index->buckets[index->hash[id] & (index->bucket_count - 1)];
+    while (*entry && *entry != id + 1) entry = &index->next[*entry - 1];
+    if (!*entry) return;
+    *entry = index->next[id];
+    index->next[id] = 0;
+}
+
+static UINT key_index_get_row( struct table_view *tv, UINT id )
+{
+    struct key_index *index = tv->table->key_index;
+    UINT i;
+
+    if (!index->id_row_valid)
+    {
+        for (i = 0; i < tv->table->row_count; i++) index->id_row[index->row_id[i]] = i;
+        index->id_row_valid = TRUE;
+    }
+    return index->id_row[id];
+}
+
+static BOOL key_index_grow( struct key_index *index, UINT size )
+{
+    UINT *next, *hash, *id_row, *row_id;
+
+    if (size <= index->size) return TRUE;
+    if (!(next = realloc( index->next, size * sizeof(*next) ))) return FALSE;
+    index->next = next;
+    if (!(hash = realloc( index->hash, size * sizeof(*hash) ))) return FALSE;
+    index->hash = hash;
+    if (!(id_row = realloc( index->id_row, size * sizeof(*id_row) ))) return FALSE;
+    index->id_row = id_row;
+    if (!(row_id = realloc( index->row_id, size * sizeof(*row_id) ))) return FALSE;
+    index->row_id = row_id;
+    index->size = size;
+    return TRUE;
+}
+
+static struct key_index *get_key_index( struct table_view *tv )
+{
+    struct key_index *index;
+    UINT count, i;
+
+    if (tv->table->key_index) return tv->table->key_index;
+
+    for (count = 16; count < tv->table->row_count; count <<= 1) ;
+
+    if (!(index = calloc( 1, sizeof(*index) ))) return NULL;
+    index->bucket_count = count;
+    tv->table->key_index = index;
+    if (!(index->buckets = calloc( count, sizeof(*index->buckets) )) || !key_index_grow( index, count ))
+    {
+        free_key_index( tv->table );
+        return NULL;
+    }
+
+    for (i = 0; i < tv->table->row_count; i++)
+    {
+        index->row_id[i] = index->id_row[i] = i;
+        key_index_add( tv, i );
+    }
+    index->id_count = tv->table->row_count;
+    index->id_row_valid = TRUE;
+    return index;
+}
+
+/* make room for a row inserted before the given one, the new row is indexed once its keys are set */
+static void key_index_insert_row( struct table_view *tv, UINT row )
+{
+    struct key_index *index = tv->table->key_index;
+    UINT id, count = tv->table->row_count;
+
+    if (!index) return;
+
+    /* rebuild the index on next use once the chains get too long */
+    if (count > index->bucket_count * 2)
+    {
+        free_key_index( tv->table );
+        return;
+    }
+
+    if (index->free_id)
+    {
+        id = index->free_id - 1;
+        index->free_id = index->next[id];
+    }
+    else
+    {
+        if (index->id_count == index->size && !key_index_grow( index, index->size * 2 ))
+        {
+            free_key_index( tv->table );
+            return;
+        }
+        id = index->id_count++;
+    }
+    index->next[id] = 0;
+    index->hash[id] = 0;
+
+    memmove( &index->row_id[row + 1], &index->row_id[row], (count - 1 - row) * sizeof(*index->row_id) );
+    index->row_id[row] = id;
+    index->id_row_valid = FALSE;
+}
+
+/* must be called before the row is removed from the table */
+static void key_index_delete_row( struct table_view *tv, UINT row )
+{
+    struct key_index *index = tv->table->key_index;
+    UINT id, count = tv->table->row_count;
+
+    if (!index) return;
+
+    key_index_remove( tv, row );
+    id = index->row_id[row];
+    index->next[id] = index->free_id;
+    index->free_id = id + 1;
+
+    memmove( &index->row_id[row], &index->row_id[row + 1], (count - 1 - row) * sizeof(*index->row_id) );
+    index->id_row_valid = FALSE;
+}
+
 /* Set a table value, i.e. preadjusted integer or string ID. */
 static UINT table_set_bytes( struct table_view *tv, UINT row, UINT col, UINT val )
 {
     UINT offset, n, i;
+    BOOL key;
 
     if( !tv->table )
         return ERROR_INVALID_PARAMETER;
@@ -1186,10 +1395,15 @@ static UINT table_set_bytes( struct table_view *tv, UINT row, UINT col, UINT val
         return ERROR_FUNCTION_FAILED;
     }
 
+    /* keep the key index in sync with the new key value */
+    key = tv->columns[col-1].type & MSITYPE_KEY;
+    if (key) key_index_remove( tv, row );
+
     offset = tv->columns[col-1].offset;
     for ( i = 0; i < n; i++ )
         tv->table->data[row][offset + i] = (val >> i * 8) & 0xff;
 
+    if (key) key_index_add( tv, row );
     return ERROR_SUCCESS;
 }
 
@@ -1733,9 +1947,16 @@ static UINT TABLE_insert_row( struct tagMSIVIEW *view, MSIRECORD *rec, UINT row,
         tv->table->data_persistent[i] = tv->table->data_persistent[i - 1];
     }
 
+    key_index_insert_row( tv, row );
+
     /* Re-set the persistence flag */
     tv->table->data_persistent[row] = !temporary;
-    return TABLE_set_row( view, row, rec, (1<<tv->num_cols) - 1 );
+    r = TABLE_set_row( view, row, rec, (1<<tv->num_cols) - 1 );
+
+    /* the row still holds the keys of the shifted row if TABLE_set_row() left them unchanged */
+    key_index_remove( tv, row );
+    key_index_add( tv, row );
+    return r;
 }
 
 static UINT TABLE_delete_row( struct tagMSIVIEW *view, UINT row )
@@ -1755,6 +1976,8 @@ static UINT TABLE_delete_row( struct tagMSIVIEW *view, UINT row )
     if ( row >= num_rows )
         return ERROR_FUNCTION_FAILED;
 
+    key_index_delete_row( tv, row );
+
     num_rows = tv->table->row_count;
     tv->table->row_count--;
 
@@ -1947,6 +2170,8 @@ static UINT TABLE_remove_column(struct tagMSIVIEW *view, UINT number)
     if (tv->table->colinfo[number-1].type & MSITYPE_TEMPORARY)
     {
         UINT size = tv->table->colinfo[number-1].offset;
+        msi_free_cached_queries( tv->db );
+        free_key_index( tv->table );
         tv->table->col_count--;
         tv->table->colinfo = realloc(tv->table->colinfo, sizeof(*tv->table->colinfo) * tv->table->col_count);
 
@@ -2013,6 +2238,7 @@ static UINT TABLE_release(struct tagMSIVIEW *view)
 
         if (!tv->table->col_count)
         {
+            msi_free_cached_queries(tv->db);
             list_remove(&tv->table->entry);
             free_table(tv->table);
             TABLE_delete(view);
@@ -2047,6 +2273,8 @@ static UINT TABLE_add_column(struct tagMSIVIEW *view, LPCWSTR column,
     if (!colinfo)
         return ERROR_OUTOFMEMORY;
     tv->table->colinfo = colinfo;
+    msi_free_cached_queries( tv->db );
+    free_key_index( tv->table );
 
     r = msi_string2id( tv->db->strings, tv->name, -1, &table_id );
     if (r != ERROR_SUCCESS)
@@ -2155,6 +2383,7 @@ static UINT TABLE_drop(struct tagMSIVIEW *view)
     if (r != ERROR_SUCCESS)
         goto done;
 
+    msi_free_cached_queries(tv->db);
     list_remove(&tv->table->entry);
     free_table(tv->table);
 
@@ -3149,10 +3378,29 @@ static UINT row_matches( struct table_view *tv, UINT row, const UINT *data, UINT
 static UINT table_find_row( struct table_view *tv, MSIRECORD *rec, UINT *row, UINT *column )
 {
     UINT i, r = ERROR_FUNCTION_FAILED, *data;
+    struct key_index *index;
 
     data = record_to_row( tv, rec );
     if( !data )
         return r;
+
+    if ((index = get_key_index( tv )))
+    {
+        UINT hash = hash_record_key( tv, data ), n;
+
+        /* keys are unique, stop at the first match */
+        for (i = index->buckets[hash & (index->bucket_count - 1)]; i; i = index->next[i - 1])
+        {
+            if (index->hash[i - 1] != hash) continue;
+            n = key_index_get_row( tv, i - 1 );
+            if ((r = row_matches( tv, n, data, column )) != ERROR_SUCCESS) continue;
+            *row = n;
+            break;
+        }
+        free( data );
+        return r;
+    }
+
     for( i = 0; i < tv->table->row_count; i++ )
     {
         r = row_matches( tv, i, data, column );
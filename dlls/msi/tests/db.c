@@ -9406,6 +9406,99 @@ static void test_viewfetch_wraparound(void)
     DeleteFileA(msifile);
 }
 
+static void test_large_tables(void)
+{
+    MSIHANDLE hdb, hview, hrec;
+    char buf[32];
+    UINT r, i, count;
+    DWORD size;
+
+    hdb = create_db();
+    ok( hdb, "failed to create db\n" );
+
+    r = run_query( hdb, 0, "CREATE TABLE `Component` (`Component` CHAR(32) NOT NULL, "
+                           "`Attributes` SHORT NOT NULL PRIMARY KEY `Component`)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = run_query( hdb, 0, "CREATE TABLE `File` (`File` CHAR(32) NOT NULL, `Component_` CHAR(32), "
+                           "`Sequence` SHORT NOT NULL PRIMARY KEY `File`, `Sequence`)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+
+    /* insert in reverse order so that rows get inserted before existing ones */
+    hrec = MsiCreateRecord( 3 );
+    for (i = 500; i > 0; i--)
+    {
+        sprintf( buf, "c%03u", i - 1 );
+        MsiRecordSetStringA( hrec, 1, buf );
+        MsiRecordSetInteger( hrec, 2, i - 1 );
+        r = run_query( hdb, hrec, "INSERT INTO `Component` (`Component`, `Attributes`) VALUES (?, ?)" );
+        ok( r == ERROR_SUCCESS, "got %u\n", r );
+    }
+    for (i = 1000; i > 0; i--)
+    {
+        sprintf( buf, "f%04u", i - 1 );
+        MsiRecordSetStringA( hrec, 1, buf );
+        sprintf( buf, "c%03u", (i - 1) % 500 );
+        MsiRecordSetStringA( hrec, 2, buf );
+        MsiRecordSetInteger( hrec, 3, i - 1 );
+        r = run_query( hdb, hrec, "INSERT INTO `File` (`File`, `Component_`, `Sequence`) VALUES (?, ?, ?)" );
+        ok( r == ERROR_SUCCESS, "got %u\n", r );
+    }
+    MsiCloseHandle( hrec );
+
+    r = run_query( hdb, 0, "INSERT INTO `Component` (`Component`, `Attributes`) VALUES ('c123', 1)" );
+    ok( r == ERROR_FUNCTION_FAILED, "got %u\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `File` (`File`, `Component_`, `Sequence`) VALUES ('f0042', 'c042', 42)" );
+    ok( r == ERROR_FUNCTION_FAILED, "got %u\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `File` (`File`, `Component_`, `Sequence`) VALUES ('f0042', 'c042', 43)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = run_query( hdb, 0, "DELETE FROM `File` WHERE `File` = 'f0042' AND `Sequence` = 43" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+
+    r = run_query( hdb, 0, "DELETE FROM `Component` WHERE `Attributes` >= 250" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Component` (`Component`, `Attributes`) VALUES ('c249', 1)" );
+    ok( r == ERROR_FUNCTION_FAILED, "got %u\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Component` (`Component`, `Attributes`) VALUES ('c250', 250)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+
+    r = MsiDatabaseOpenViewA( hdb, "SELECT `File`, `Attributes` FROM `File`, `Component` "
+                              "WHERE `Component_` = `Component`", &hview );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = MsiViewExecute( hview, 0 );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    count = 0;
+    while (!MsiViewFetch( hview, &hrec ))
+    {
+        size = sizeof(buf);
+        MsiRecordGetStringA( hrec, 1, buf, &size );
+        i = atoi( buf + 1 );
+        ok( i % 500 <= 250, "got %s\n", buf );
+        ok( MsiRecordGetInteger( hrec, 2 ) == i % 500, "got %d for %s\n", MsiRecordGetInteger( hrec, 2 ), buf );
+        MsiCloseHandle( hrec );
+        count++;
+    }
+    ok( count == 502, "got %u\n", count );
+    MsiViewClose( hview );
+    MsiCloseHandle( hview );
+
+    r = MsiDatabaseOpenViewA( hdb, "SELECT `File` FROM `Component`, `File` "
+                              "WHERE `Attributes` = `Sequence` AND `Component` = 'c007'", &hview );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = MsiViewExecute( hview, 0 );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = MsiViewFetch( hview, &hrec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( hrec, 1, "f0007" );
+    MsiCloseHandle( hrec );
+    r = MsiViewFetch( hview, &hrec );
+    ok( r == ERROR_NO_MORE_ITEMS, "got %u\n", r );
+    MsiViewClose( hview );
+    MsiCloseHandle( hview );
+
+    MsiCloseHandle( hdb );
+    DeleteFileA( msifile );
+}
+
 START_TEST(db)
 {
     test_msidatabase();
@@ -9466,4 +9559,5 @@ START_TEST(db)
     test_viewmodify_insert();
     test_view_get_error();
     test_viewfetch_wraparound();
+    test_large_tables();
 }
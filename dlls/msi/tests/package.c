@@ -2492,6 +2492,77 @@ static void test_property_table(void)
     DeleteFileA(msifile);
 }
 
+static void test_query_cache(void)
+{
+    MSIHANDLE hpkg, hdb, hview, hrec, hparam;
+    UINT r, i;
+
+    hdb = create_package_db();
+    ok( hdb, "failed to create package\n" );
+
+    r = package_from_db( hdb, &hpkg );
+    if (r == ERROR_INSTALL_PACKAGE_REJECTED)
+    {
+        skip( "Not enough rights to perform tests\n" );
+        DeleteFileA( msifile );
+        return;
+    }
+    ok( r == ERROR_SUCCESS, "failed to create package %u\n", r );
+
+    hdb = MsiGetActiveDatabase( hpkg );
+
+    r = run_query( hdb, "CREATE TABLE `Cache` (`Key` CHAR(32) NOT NULL, `Value` INT PRIMARY KEY `Key`)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = run_query( hdb, "INSERT INTO `Cache` (`Key`, `Value`) VALUES ('a', 1)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = run_query( hdb, "INSERT INTO `Cache` (`Key`, `Value`) VALUES ('b', 2)" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+
+    /* the same query opened again has to be bound to the new parameters */
+    hparam = MsiCreateRecord( 1 );
+    for (i = 0; i < 4; i++)
+    {
+        r = MsiDatabaseOpenViewA( hdb, "SELECT `Value` FROM `Cache` WHERE `Key` = ?", &hview );
+        ok( r == ERROR_SUCCESS, "got %u\n", r );
+        MsiRecordSetStringA( hparam, 1, i % 2 ? "b" : "a" );
+        r = MsiViewExecute( hview, hparam );
+        ok( r == ERROR_SUCCESS, "got %u\n", r );
+        r = MsiViewFetch( hview, &hrec );
+        ok( r == ERROR_SUCCESS, "got %u\n", r );
+        ok( MsiRecordGetInteger( hrec, 1 ) == i % 2 + 1, "got %d\n", MsiRecordGetInteger( hrec, 1 ) );
+        MsiCloseHandle( hrec );
+        r = MsiViewFetch( hview, &hrec );
+        ok( r == ERROR_NO_MORE_ITEMS, "got %u\n", r );
+        /* closing the handle without closing the view first */
+        if (i % 2) MsiViewClose( hview );
+        MsiCloseHandle( hview );
+    }
+    MsiCloseHandle( hparam );
+
+    r = do_query( hdb, "SELECT * FROM `Cache` WHERE `Key` = 'a'", &hrec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    ok( MsiRecordGetFieldCount( hrec ) == 2, "got %u\n", MsiRecordGetFieldCount( hrec ) );
+    MsiCloseHandle( hrec );
+
+    r = run_query( hdb, "ALTER TABLE `Cache` ADD `Extra` INTEGER" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+
+    r = do_query( hdb, "SELECT * FROM `Cache` WHERE `Key` = 'a'", &hrec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    ok( MsiRecordGetFieldCount( hrec ) == 3, "got %u\n", MsiRecordGetFieldCount( hrec ) );
+    MsiCloseHandle( hrec );
+
+    r = run_query( hdb, "DROP TABLE `Cache`" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+
+    r = do_query( hdb, "SELECT * FROM `Cache` WHERE `Key` = 'a'", &hrec );
+    ok( r == ERROR_BAD_QUERY_SYNTAX, "got %u\n", r );
+
+    MsiCloseHandle( hdb );
+    MsiCloseHandle( hpkg );
+    DeleteFileA( msifile );
+}
+
 static UINT try_query_param( MSIHANDLE hdb, LPCSTR szQuery, MSIHANDLE hrec )
 {
     MSIHANDLE htab = 0;
@@ -9673,6 +9744,7 @@ START_TEST(package)
     test_settargetpath();
     test_props();
     test_property_table();
+    test_query_cache();
     test_condition();
     test_msipackage();
     test_formatrecord2();
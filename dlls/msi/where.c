@@ -44,6 +44,16 @@ struct row_entry
     UINT values[1];
 };
 
+/* Rows of a joined table hashed by the value of a column that the condition
+ * compares for equality with a column of an outer table, see build_join_index(). */
+struct join_index
+{
+    const struct expr *probe;   /* column of the outer table */
+    UINT  bucket_count;
+    UINT *buckets;              /* first row + 1 in each bucket, 0 if empty */
+    UINT *next;                 /* next row + 1 in the same bucket */
+};
+
 struct join_table
 {
     struct join_table *next;
@@ -51,6 +61,7 @@ struct join_table
     UINT col_count;
     UINT row_count;
     UINT table_index;
+    struct join_index *index;
 };
 
 typedef struct tagMSIORDERINFO
@@ -647,15 +658,63 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+static UINT join_hash( MSIWHEREVIEW *wv, const struct expr *expr, UINT value )
+{
+    const WCHAR *str;
+    UINT hash = 0;
+
+    /* hash the value as WHERE_evaluate() compares it */
+    switch (expr->type)
+    {
+    case EXPR_COL_NUMBER:
+        hash = value - 0x8000;
+        break;
+    case EXPR_COL_NUMBER32:
+        hash = value - 0x80000000;
+        break;
+    default:
+        /* null and empty strings compare equal */
+        if ((str = msi_string_lookup( wv->db->strings, value, NULL )))
+            while (*str) hash = hash * 31 + *str++;
+        break;
+    }
+    return hash * 0x9e3779b1;
+}
+
+/* returns the first row of the table which may satisfy the condition */
+static UINT first_row( MSIWHEREVIEW *wv, struct join_table *table, const UINT rows[], BOOL *indexed )
+{
+    struct join_index *index = table->index;
+    UINT value;
+
+    *indexed = FALSE;
+    if (!index || expr_fetch_value( &index->probe->u.column, rows, &value ) != ERROR_SUCCESS)
+        return 0;
+
+    *indexed = TRUE;
+    return index->buckets[join_hash( wv, index->probe, value ) & (index->bucket_count - 1)] - 1;
+}
+
+static inline UINT next_row( struct join_table *table, UINT row, BOOL indexed )
+{
+    if (!indexed) return row + 1;
+    return table->index->next[row] - 1;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, struct join_table **tables,
                              UINT table_rows[] )
 {
     UINT r = ERROR_FUNCTION_FAILED;
+    BOOL indexed;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    table_rows[(*tables)->table_index] = first_row( wv, *tables, table_rows, &indexed );
+
+    /* no row of the table matching the outer tables isn't an error */
+    if (indexed) r = ERROR_SUCCESS;
+
+    for (; table_rows[(*tables)->table_index] < (*tables)->row_count;
+         table_rows[(*tables)->table_index] = next_row( *tables, table_rows[(*tables)->table_index], indexed ))
     {
         val = 0;
         wv->rec_index = 0;
@@ -786,6 +845,104 @@ static UINT reorder_check( const struct expr *expr, struct join_table **ordered_
     }
 }
 
+static BOOL is_join_column( const struct expr *expr )
+{
+    return expr->type == EXPR_COL_NUMBER || expr->type == EXPR_COL_NUMBER32 ||
+           expr->type == EXPR_COL_NUMBER_STRING;
+}
+
+/* find an equality between a column of the table and one of the outer tables
+ * which has to hold for the whole condition to be true */
+static BOOL find_join_expr( const struct expr *cond, const struct join_table *table,
+                            struct join_table **outer, UINT outer_count,
+                            const struct expr **column, const struct expr **probe )
+{
+    const struct expr *left, *right;
+    UINT i;
+
+    if (cond->type != EXPR_COMPLEX && cond->type != EXPR_STRCMP)
+        return FALSE;
+
+    if (cond->type == EXPR_COMPLEX && cond->u.expr.op == OP_AND)
+        return find_join_expr( cond->u.expr.left, table, outer, outer_count, column, probe ) ||
+               find_join_expr( cond->u.expr.right, table, outer, outer_count, column, probe );
+
+    left = cond->u.expr.left;
+    right = cond->u.expr.right;
+    if (cond->u.expr.op != OP_EQ || !is_join_column( left ) || !is_join_column( right ))
+        return FALSE;
+    if ((left->type == EXPR_COL_NUMBER_STRING) != (right->type == EXPR_COL_NUMBER_STRING))
+        return FALSE;
+
+    if (right->u.column.parsed.table == table)
+    {
+        const struct expr *tmp = left;
+        left = right;
+        right = tmp;
+    }
+    if (left->u.column.parsed.table != table)
+        return FALSE;
+
+    for (i = 0; i < outer_count; i++)
+    {
+        if (right->u.column.parsed.table != outer[i]) continue;
+        *column = left;
+        *probe = right;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* Index the table on its join column so that check_condition() only has to
+ * visit the rows matching the current row of the outer table. */
+static void build_join_index( MSIWHEREVIEW *wv, struct join_table **tables, UINT count )
+{
+    struct join_table *table = tables[count];
+    const struct expr *column, *probe;
+    struct join_index *index;
+    UINT size, row, value, hash;
+
+    if (!wv->cond || !find_join_expr( wv->cond, table, tables, count, &column, &probe ))
+        return;
+
+    for (size = 16; size < table->row_count; size <<= 1) ;
+
+    if (!(index = malloc( sizeof(*index) ))) return;
+    index->probe = probe;
+    index->bucket_count = size;
+    index->buckets = calloc( size, sizeof(*index->buckets) );
+    index->next = calloc( table->row_count, sizeof(*index->next) );
+    if (!index->buckets || !index->next) goto error;
+
+    /* add rows in reverse order so that buckets are sorted by row */
+    for (row = table->row_count; row > 0; row--)
+    {
+        if (table->view->ops->fetch_int( table->view, row - 1, column->u.column.parsed.column, &value ))
+            goto error;
+        hash = join_hash( wv, column, value ) & (size - 1);
+        index->next[row - 1] = index->buckets[hash];
+        index->buckets[hash] = row;
+    }
+
+    TRACE("indexed %u rows of table %u\n", table->row_count, table->table_index);
+    table->index = index;
+    return;
+
+error:
+    free( index->buckets );
+    free( index->next );
+    free( index );
+}
+
+static void free_join_index( struct join_table *table )
+{
+    if (!table->index) return;
+    free( table->index->buckets );
+    free( table->index->next );
+    free( table->index );
+    table->index = NULL;
+}
+
 /* reorders the tablelist in a way to evaluate the condition as fast as possible */
 static struct join_table **ordertables( MSIWHEREVIEW *wv )
 {
@@ -851,8 +1008,14 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
     for (i = 0; i < wv->table_count; i++)
         rows[i] = INVALID_ROW_INDEX;
 
+    for (i = 1; ordered_tables[i]; i++)
+        build_join_index( wv, ordered_tables, i );
+
     r =  check_condition(wv, record, ordered_tables, rows);
 
+    for (table = wv->tables; table; table = table->next)
+        free_join_index( table );
+
     if (wv->order_info)
         wv->order_info->error = ERROR_SUCCESS;
 
@@ -1255,6 +1418,7 @@ UINT WHERE_CreateView( MSIDATABASE *db, MSIVIEW **view, LPWSTR tables,
             r = ERROR_OUTOFMEMORY;
             goto end;
         }
+        table->index = NULL;
 
         r = TABLE_CreateView(db, tables, &table->view);
         if (r != ERROR_SUCCESS)
@@ -24,6 +24,27 @@
 
 static const int p10s[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
 
+/* powers of 5 that fit in 63 bits */
+static const ULONGLONG p5s[] = {
+    1ull, 5ull, 25ull, 125ull, 625ull, 3125ull, 15625ull, 78125ull, 390625ull,
+    1953125ull, 9765625ull, 48828125ull, 244140625ull, 1220703125ull,
+    6103515625ull, 30517578125ull, 152587890625ull, 762939453125ull,
+    3814697265625ull, 19073486328125ull, 95367431640625ull, 476837158203125ull,
+    2384185791015625ull, 11920928955078125ull, 59604644775390625ull,
+    298023223876953125ull, 1490116119384765625ull, 7450580596923828125ull
+};
+
+/* Returns low 64 bits of a*b, high 64 bits are stored in hi */
+static inline ULONGLONG mul_64x64(ULONGLONG a, ULONGLONG b, ULONGLONG *hi)
+{
+    ULONGLONG al = (DWORD)a, ah = a >> 32, bl = (DWORD)b, bh = b >> 32;
+    ULONGLONG ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    ULONGLONG mid = (ll >> 32) + (DWORD)lh + (DWORD)hl;
+
+    *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return (mid << 32) | (DWORD)ll;
+}
+
 #define LIMB_DIGITS 9           /* each DWORD stores up to 9 digits */
 #define LIMB_MAX 1000000000     /* 10^9 */
 
@@ -134,4 +155,81 @@ static inline void bnum_mult(struct bnum *b, int mult)
     }
 }
 
+/* Stores m*2^e2 in b, sets e10 to decimal exponent of b->data[b->e-2] limb */
+static inline void bnum_from_fp(struct bnum *b, ULONGLONG m, int e2, int *e10)
+{
+    b->b = 0;
+    b->e = 2;
+    b->size = BNUM_PREC64;
+    b->data[0] = m % LIMB_MAX;
+    b->data[1] = m / LIMB_MAX;
+    *e10 = 0;
+
+    while(e2 > 0) {
+        int shift = e2 > 29 ? 29 : e2;
+        if(bnum_lshift(b, shift)) *e10 += LIMB_DIGITS;
+        e2 -= shift;
+    }
+    while(e2 < 0) {
+        int shift = -e2 > 9 ? 9 : -e2;
+        if(bnum_rshift(b, shift)) *e10 -= LIMB_DIGITS;
+        e2 += shift;
+    }
+}
+
+/* Like bnum_from_fp, but only computes first 18 or 19 significant digits of
+ * m*2^e2 (where m has MANT_BITS bits) using 128-bit arithmetic. They are
+ * followed by a limb that is non-zero if any of the dropped digits is, so
+ * the result may be used for rounding to fewer digits than returned.
+ * Returns 0 if the value is out of range for the fast path. */
+static inline int bnum_from_fp_fast(struct bnum *b, ULONGLONG m, int e2, int *e10)
+{
+    ULONGLONG hi, lo, q;
+    int k, s, shift, digits;
+    DWORD rest;
+
+    /* k = floor(log10(2^(e2+MANT_BITS-1))), 78913 / 2^18 approximates log10(2) */
+    k = e2 + MANT_BITS - 1;
+    if(k < -33 || k > 59) return 0;
+    if(k >= 0) k = (k * 78913) >> 18;
+    else k = -((-k * 78913 + (1 << 18) - 1) >> 18);
+
+    /* scale the value so it's in [10^17, 2*10^18) range */
+    s = 17 - k;
+    if(s < 0 || s >= ARRAY_SIZE(p5s)) return 0;
+    lo = mul_64x64(m, p5s[s], &hi);
+    shift = e2 + s;
+
+    if(shift >= 0) {
+        if(hi || shift >= 64 || lo >> (63 - shift) >> 1) return 0;
+        q = lo << shift;
+        rest = 0;
+    } else {
+        shift = -shift;
+        if(shift >= 64 || hi >> shift) return 0;
+        q = (hi << (64 - shift)) | (lo >> shift);
+        rest = (lo & (((ULONGLONG)1 << shift) - 1)) != 0;
+    }
+    if(q < 100000000000000000ull) return 0;
+    digits = q >= 1000000000000000000ull ? 19 : 18;
+
+    /* decimal point needs to be on limb boundary */
+    b->b = 0;
+    b->e = 1;
+    b->size = BNUM_PREC64;
+    b->data[0] = rest;
+    k = s % LIMB_DIGITS;
+    if(k) {
+        b->data[b->e++] = q % p10s[k] * p10s[LIMB_DIGITS - k];
+        q /= p10s[k];
+    }
+    while(q) {
+        b->data[b->e++] = q % LIMB_MAX;
+        q /= LIMB_MAX;
+    }
+
+    *e10 = LIMB_DIGITS * (b->e - 3 - (k != 0)) - (s - k);
+    return digits;
+}
+
 #endif /* __WINE_BNUM_H */
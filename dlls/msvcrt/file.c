@@ -2982,7 +2982,19 @@ static int read_i(int fd, ioinfo *fdinfo, void *buf, unsigned int count)
             else
                 fdinfo->wxflag &= ~WX_READNL;
 
-            for (i=0, j=0; i<num_read; i+=1+utf16)
+            i = j = 0;
+            if (!utf16)
+            {
+                /* skip the part of the buffer that doesn't need translation */
+                char *cr = memchr(bufstart, '\r', num_read);
+                char *eof = memchr(bufstart, 0x1a, cr ? cr - bufstart : num_read);
+
+                if (eof) i = j = eof - bufstart;
+                else if (cr) i = j = cr - bufstart;
+                else i = j = num_read;
+            }
+
+            for (; i<num_read; i+=1+utf16)
             {
                 /* in text mode, a ctrl-z signals EOF */
                 if (bufstart[i]==0x1a && (!utf16 || bufstart[i+1]==0))
@@ -3596,7 +3608,9 @@ int CDECL _write(int fd, const void* buf, unsigned int count)
     if (info->wxflag & WX_APPEND)
         _lseek(fd, 0, FILE_END);
 
-    if (!(info->wxflag & WX_TEXT))
+    /* ANSI text without newlines needs no translation unless it goes to the console */
+    if (!(info->wxflag & WX_TEXT) || (ioinfo_get_textmode(info) == TEXTMODE_ANSI &&
+                !_isatty(fd) && !memchr(buf, '\n', count)))
     {
         if (!WriteFile(hand, buf, count, &num_written, NULL)
                 ||  num_written != count)
@@ -3674,11 +3688,22 @@ int CDECL _write(int fd, const void* buf, unsigned int count)
         }
         else if (ioinfo_get_textmode(info) == TEXTMODE_ANSI)
         {
-            for (j = 0; i < count && j < sizeof(lfbuf)-1; i++, j++)
+            const char *nl;
+            DWORD len;
+
+            while (i < count && j < sizeof(lfbuf)-1)
             {
-                if (s[i] == '\n')
+                len = min(count - i, sizeof(lfbuf) - 1 - j);
+                if ((nl = memchr(s + i, '\n', len))) len = nl - (s + i);
+                memcpy(lfbuf + j, s + i, len);
+                i += len;
+                j += len;
+                if (nl)
+                {
                     lfbuf[j++] = '\r';
-                lfbuf[j] = s[i];
+                    lfbuf[j++] = '\n';
+                    i++;
+                }
             }
         }
         else if (ioinfo_get_textmode(info) == TEXTMODE_UTF16LE || console)
@@ -19,6 +19,12 @@
  *
  * Note: Win32 heap operations are MT safe. We only lock the new
  *       handler and non atomic heap operations
+ *
+ *       Small block allocations are served by the ntdll heap LFH, which
+ *       keeps per-thread block groups and doesn't take the heap lock.
+ *       Don't cache blocks here, it would break _msize and _heapwalk.
+ *       Aligned blocks are kept in small size classes where possible,
+ *       see aligned_alloc_size().
  */
 
 #include <malloc.h>
@@ -41,6 +47,21 @@ WINE_DEFAULT_DEBUG_CHANNEL(msvcrt);
 
 #define SB_HEAP_ALIGN 16
 
+/* Size to allocate for an aligned block, including room for the saved pointer.
+ * Heap blocks are already aligned to MEMORY_ALLOCATION_ALIGNMENT, so for smaller
+ * alignments ALIGN_PTR always adds the same padding and we don't need to allocate
+ * for the worst case; this keeps e.g. 16-byte aligned blocks with 16-byte multiple
+ * sizes in a 16-byte multiple size class.  _aligned_msize() assumes the worst case
+ * padding though, so only do this where it isn't exported. */
+static size_t aligned_alloc_size(size_t size, size_t alignment, size_t offset)
+{
+#if _MSVCR_VER < 80
+    if (!offset && alignment <= MEMORY_ALLOCATION_ALIGNMENT)
+        return size + ((alignment + sizeof(void *)) & ~(alignment - 1));
+#endif
+    return size + alignment + sizeof(void *);
+}
+
 static HANDLE heap, sb_heap;
 
 typedef int (CDECL *MSVCRT_new_handler_func)(size_t size);
@@ -581,7 +602,7 @@ void * CDECL _aligned_offset_malloc(size_t size, size_t alignment, size_t offset
         alignment = sizeof(void *);
 
     /* allocate enough space for void pointer and alignment */
-    temp = malloc(size + alignment + sizeof(void *));
+    temp = malloc(aligned_alloc_size(size, alignment, offset));
 
     if (!temp)
         return NULL;
@@ -669,7 +690,7 @@ void * CDECL _aligned_offset_realloc(void *memblock, size_t size,
     }
     old_size -= old_padding;
 
-    temp = realloc(*saved, size + alignment + sizeof(void *));
+    temp = realloc(*saved, aligned_alloc_size(size, alignment, offset));
 
     if (!temp)
         return NULL;
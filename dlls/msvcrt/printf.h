@@ -621,23 +621,21 @@ static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *pu
     if(v) {
         m = (ULONGLONG)1 << (MANT_BITS - 1);
         m |= (*(ULONGLONG*)&v & (((ULONGLONG)1 << (MANT_BITS - 1)) - 1));
-        b->b = 0;
-        b->e = 2;
-        b->size = BNUM_PREC64;
-        b->data[0] = m % LIMB_MAX;
-        b->data[1] = m / LIMB_MAX;
         e2 -= MANT_BITS;
 
-        while(e2 > 0) {
-            int shift = e2 > 29 ? 29 : e2;
-            if(bnum_lshift(b, shift)) e10 += LIMB_DIGITS;
-            e2 -= shift;
-        }
-        while(e2 < 0) {
-            int shift = -e2 > 9 ? 9 : -e2;
-            if(bnum_rshift(b, shift)) e10 -= LIMB_DIGITS;
-            e2 += shift;
+        /* Most of the time only a few leading digits are printed, try to
+         * avoid computing the exact decimal expansion of the number. */
+        len = bnum_from_fp_fast(b, m, e2, &e10);
+        if(len) {
+            radix_pos = log10i(b->data[bnum_idx(b, b->e - 1)]) + 1 + LIMB_DIGITS + e10;
+            round_pos = flags->Precision;
+            if(flags->Format=='f' || flags->Format=='F')
+                round_pos += radix_pos;
+            else if(!flags->Precision || flags->Format=='e' || flags->Format=='E')
+                round_pos++;
+            if(round_pos < 1 || round_pos >= len) len = 0;
         }
+        if(!len) bnum_from_fp(b, m, e2, &e10);
     } else {
         b->b = 0;
         b->e = 1;
@@ -742,6 +742,65 @@ static inline BOOL bnum_to_mant(struct bnum *b, ULONGLONG *m)
     return TRUE;
 }
 
+/* Converts m*10^e10 without big number arithmetic. 5^|e10| needs to fit in
+ * 63 bits so the product or quotient can be computed exactly. */
+static BOOL fpnum_from_decimal(int sign, ULONGLONG m, int e10, struct fpnum *ret)
+{
+    ULONGLONG hi, lo, q, r, d;
+    enum fpmod mod;
+    int n;
+
+    if(e10 >= 0) {
+        if(e10 >= ARRAY_SIZE(p5s)) return FALSE;
+
+        lo = mul_64x64(m, p5s[e10], &hi);
+        if(!hi) {
+            *ret = fpnum(sign, e10, lo, FP_ROUND_ZERO);
+            return TRUE;
+        }
+
+        for(n = 1; n < 64 && hi >> n; n++);
+        if(n == 64) {
+            q = hi;
+            r = lo;
+        } else {
+            q = (hi << (64 - n)) | (lo >> n);
+            r = lo & (((ULONGLONG)1 << n) - 1);
+        }
+        d = (ULONGLONG)1 << (n - 1);
+
+        if(!r) mod = FP_ROUND_ZERO;
+        else if(r < d) mod = FP_ROUND_DOWN;
+        else if(r == d) mod = FP_ROUND_EVEN;
+        else mod = FP_ROUND_UP;
+        *ret = fpnum(sign, e10 + n, q, mod);
+        return TRUE;
+    }
+
+    if(-e10 >= ARRAY_SIZE(p5s)) return FALSE;
+
+    /* m * 10^e10 = (m * 2^n / 5^-e10) * 2^(e10-n), compute the quotient
+     * bit by bit until it has 64 significant bits */
+    d = p5s[-e10];
+    q = m / d;
+    r = m % d;
+    for(n = 0; !(q >> 63); n++) {
+        q <<= 1;
+        r <<= 1;
+        if(r >= d) {
+            r -= d;
+            q |= 1;
+        }
+    }
+
+    /* d is odd, so the remainder is never exactly half of it */
+    if(!r) mod = FP_ROUND_ZERO;
+    else if(2 * r < d) mod = FP_ROUND_DOWN;
+    else mod = FP_ROUND_UP;
+    *ret = fpnum(sign, e10 - n, q, mod);
+    return TRUE;
+}
+
 static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(void *ctx),
         void *ctx, pthreadlocinfo locinfo, BOOL ldouble, struct bnum *b)
 {
@@ -917,6 +976,25 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
     if(!b->data[bnum_idx(b, b->e-1)])
         return fpnum(sign, 0, 0, 0);
 
+    /* Try to convert numbers with up to 19 digits directly */
+    i = (b->e - 1 - b->b) * LIMB_DIGITS + limb_digits;
+    if(!ldouble && i <= 19 && dp > -LIMB_DIGITS * 4 && dp < LIMB_DIGITS * 8) {
+        struct fpnum ret;
+        int e10 = dp - i;
+
+        m = 0;
+        for(i = b->e-1; i > b->b; i--)
+            m = m * LIMB_MAX + b->data[bnum_idx(b, i)];
+        m = m * p10s[limb_digits] + b->data[bnum_idx(b, b->b)];
+
+        while(e10 < 0 && !(m % 10)) {
+            m /= 10;
+            e10++;
+        }
+        if(fpnum_from_decimal(sign, m, e10, &ret))
+            return ret;
+    }
+
     /* Fill last limb with 0 if needed */
     if(b->b+1 != b->e) {
         for(; limb_digits != LIMB_DIGITS; limb_digits++)
@@ -1559,13 +1637,23 @@ int CDECL _atoldbl(_LDOUBLE *value, char *str)
     return _atoldbl_l( (MSVCRT__LDOUBLE*)value, str, NULL );
 }
 
+/* non-zero if any of the bytes in the 64-bit block is zero */
+#define BLOCK_HAS_ZERO(v) (((v) - 0x0101010101010101ull) & ~(v) & 0x8080808080808080ull)
+
 /*********************************************************************
  *              strlen (MSVCRT.@)
  */
 size_t __cdecl strlen(const char *str)
 {
     const char *s = str;
-    while (*s) s++;
+    const uint64_t *p;
+
+    for (; (uintptr_t)s & (sizeof(uint64_t) - 1); s++)
+        if (!*s) return s - str;
+
+    /* aligned blocks never cross a page boundary */
+    for (p = (const uint64_t *)s; !BLOCK_HAS_ZERO(*p); p++);
+    for (s = (const char *)p; *s; s++);
     return s - str;
 }
 
@@ -3248,11 +3336,22 @@ void *__cdecl memset(void *dst, int c, size_t n)
  */
 char* __cdecl strchr(const char *str, int c)
 {
-    do
+    uint64_t v = 0x0101010101010101ull * (unsigned char)c;
+    const uint64_t *p;
+
+    for (; (uintptr_t)str & (sizeof(uint64_t) - 1); str++)
     {
         if (*str == (char)c) return (char*)str;
-    } while (*str++);
-    return NULL;
+        if (!*str) return NULL;
+    }
+
+    for (p = (const uint64_t *)str; !BLOCK_HAS_ZERO(*p) && !BLOCK_HAS_ZERO(*p ^ v); p++);
+
+    for (str = (const char *)p;; str++)
+    {
+        if (*str == (char)c) return (char*)str;
+        if (!*str) return NULL;
+    }
 }
 
 /*********************************************************************
@@ -3270,9 +3369,17 @@ char* __cdecl strrchr(const char *str, int c)
  */
 void* __cdecl memchr(const void *ptr, int c, size_t n)
 {
+    uint64_t v = 0x0101010101010101ull * (unsigned char)c;
     const unsigned char *p = ptr;
+    const uint64_t *b;
+
+    for (; (uintptr_t)p & (sizeof(uint64_t) - 1) && n; n--, p++)
+        if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
+
+    for (b = (const uint64_t *)p; n >= sizeof(uint64_t) && !BLOCK_HAS_ZERO(*b ^ v); b++)
+        n -= sizeof(uint64_t);
 
-    for (p = ptr; n; n--, p++) if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
+    for (p = (const unsigned char *)b; n; n--, p++) if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
     return NULL;
 }
 
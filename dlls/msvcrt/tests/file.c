@@ -569,6 +569,40 @@ static void test_asciimode2(void)
     unlink("ascii2.tst");
 }
 
+static void test_asciimode_large(void)
+{
+    static char obuf[10000], ibuf[sizeof(obuf) + 200];
+    FILE *fp;
+    int i, fd;
+
+    for (i = 0; i < sizeof(obuf); i++)
+        obuf[i] = i % 100 == 99 ? '\n' : 'a' + i % 26;
+
+    fd = _open("asciilarge.tst", _O_CREAT | _O_TRUNC | _O_WRONLY | _O_TEXT, _S_IREAD | _S_IWRITE);
+    ok(fd != -1, "_open failed\n");
+    i = _write(fd, obuf, 99);
+    ok(i == 99, "_write returned %d\n", i);
+    i = _write(fd, obuf, sizeof(obuf));
+    ok(i == sizeof(obuf), "_write returned %d\n", i);
+    _close(fd);
+
+    fp = fopen("asciilarge.tst", "rb");
+    i = fread(ibuf, 1, sizeof(ibuf), fp);
+    ok(i == 99 + sizeof(obuf) + sizeof(obuf) / 100, "fread returned %d\n", i);
+    ok(!memcmp(ibuf, obuf, 99), "ibuf != obuf\n");
+    ok(!memcmp(ibuf + 99, obuf, 99), "ibuf != obuf\n");
+    ok(ibuf[99 + 99] == '\r' && ibuf[99 + 100] == '\n', "got %x %x\n", ibuf[99 + 99], ibuf[99 + 100]);
+    fclose(fp);
+
+    fp = fopen("asciilarge.tst", "rt");
+    i = fread(ibuf, 1, sizeof(ibuf), fp);
+    ok(i == 99 + sizeof(obuf), "fread returned %d\n", i);
+    ok(!memcmp(ibuf, obuf, 99), "ibuf != obuf\n");
+    ok(!memcmp(ibuf + 99, obuf, sizeof(obuf)), "ibuf != obuf\n");
+    fclose(fp);
+    unlink("asciilarge.tst");
+}
+
 static void test_filemodeT(void)
 {
     char DATA  [] = {26, 't', 'e', 's' ,'t'};
@@ -3099,6 +3133,7 @@ START_TEST(file)
     test_fileops();
     test_asciimode();
     test_asciimode2();
+    test_asciimode_large();
     test_filemodeT();
     test_readmode(FALSE); /* binary mode */
     test_readmode(TRUE);  /* ascii mode */
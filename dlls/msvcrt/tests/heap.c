@@ -233,6 +233,39 @@ static void test_aligned_offset_realloc(unsigned int size1, unsigned int size2,
         ok(errno == EINVAL, "_aligned_offset_malloc(%d, %d) errno: %d != %d\n", size1, alignment, errno, EINVAL);
 }
 
+static void test_aligned_small(unsigned int alignment)
+{
+    unsigned char *mem[256] = { NULL };
+    unsigned int i, j;
+
+    for (i = 0; i < ARRAY_SIZE(mem); i++)
+    {
+        mem[i] = p_aligned_malloc(i + 1, alignment);
+        ok(mem[i] != NULL, "_aligned_malloc(%d, %d) failed\n", i + 1, alignment);
+        if (!mem[i]) break;
+        ok(((DWORD_PTR)mem[i] & (alignment - 1)) == 0, "_aligned_malloc(%d, %d) not aligned: %p\n",
+           i + 1, alignment, mem[i]);
+        memset(mem[i], i, i + 1);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(mem) && mem[i]; i++)
+    {
+        for (j = 0; j <= i; j++) if (mem[i][j] != (unsigned char)i) break;
+        ok(j > i, "block %d of alignment %d overwritten at %d\n", i + 1, alignment, j);
+
+        mem[i] = p_aligned_realloc(mem[i], 2 * (i + 1), alignment);
+        ok(mem[i] != NULL, "_aligned_realloc(%d, %d) failed\n", 2 * (i + 1), alignment);
+        if (!mem[i]) continue;
+        ok(((DWORD_PTR)mem[i] & (alignment - 1)) == 0, "_aligned_realloc(%d, %d) not aligned: %p\n",
+           2 * (i + 1), alignment, mem[i]);
+        for (j = 0; j <= i; j++) if (mem[i][j] != (unsigned char)i) break;
+        ok(j > i, "block %d of alignment %d not copied at %d\n", i + 1, alignment, j);
+        memset(mem[i] + i + 1, ~i, i + 1);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(mem); i++) p_aligned_free(mem[i]);
+}
+
 static void test_aligned(void)
 {
     HMODULE msvcrt = GetModuleHandleA("msvcrt.dll");
@@ -264,6 +297,10 @@ static void test_aligned(void)
     test_aligned_malloc(256, 127);
     test_aligned_malloc(256, 128);
 
+    test_aligned_small(4);
+    test_aligned_small(8);
+    test_aligned_small(16);
+
     test_aligned_offset_malloc(256, 0, 0);
     test_aligned_offset_malloc(256, 1, 0);
     test_aligned_offset_malloc(256, 2, 0);
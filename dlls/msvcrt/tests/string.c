@@ -1903,6 +1903,66 @@ static void test_strnlen(void)
     ok(res == 0, "Returned length = %d\n", (int)res);
 }
 
+static void test_strlen_strchr_memchr(void)
+{
+    char buf[80];
+    wchar_t wbuf[40];
+    const char *p;
+    size_t res;
+    int i, len;
+
+    for (i = 0; i < 16; i++)
+    {
+        for (len = 0; len < 40; len++)
+        {
+            memset(buf, 'a', sizeof(buf));
+            buf[i + len] = 0;
+            buf[i + len + 1] = 'x';
+
+            res = strlen(buf + i);
+            ok(res == len, "%d:%d: strlen returned %Iu\n", i, len, res);
+
+            p = strchr(buf + i, 'x');
+            ok(!p, "%d:%d: strchr returned %p\n", i, len, p);
+            p = strchr(buf + i, 0);
+            ok(p == buf + i + len, "%d:%d: strchr returned %p, expected %p\n", i, len, p, buf + i + len);
+            p = memchr(buf + i, 'x', len + 1);
+            ok(!p, "%d:%d: memchr returned %p\n", i, len, p);
+            p = memchr(buf + i, 'x', len + 2);
+            ok(p == buf + i + len + 1, "%d:%d: memchr returned %p, expected %p\n", i, len, p, buf + i + len + 1);
+
+            if (len)
+            {
+                buf[i + len - 1] = 'b';
+                p = strchr(buf + i, 'b');
+                ok(p == buf + i + len - 1, "%d:%d: strchr returned %p, expected %p\n", i, len, p, buf + i + len - 1);
+                p = memchr(buf + i, 'b', len);
+                ok(p == buf + i + len - 1, "%d:%d: memchr returned %p, expected %p\n", i, len, p, buf + i + len - 1);
+                buf[i + len - 1] = 0x80;
+                p = strchr(buf + i, 0x80);
+                ok(p == buf + i + len - 1, "%d:%d: strchr returned %p, expected %p\n", i, len, p, buf + i + len - 1);
+            }
+        }
+    }
+
+    for (i = 0; i < 8; i++)
+    {
+        for (len = 0; len < 24; len++)
+        {
+            wmemset(wbuf, 0x100, ARRAY_SIZE(wbuf));
+            wbuf[i + len] = 0;
+            res = wcslen(wbuf + i);
+            ok(res == len, "%d:%d: wcslen returned %Iu\n", i, len, res);
+        }
+    }
+
+    /* unaligned wide string */
+    memset(buf, 1, sizeof(buf));
+    buf[41] = buf[42] = 0;
+    res = wcslen((wchar_t *)(buf + 1));
+    ok(res == 20, "wcslen returned %Iu\n", res);
+}
+
 static void test__strtoi64(void)
 {
     static const char no1[] = "31923";
@@ -2164,6 +2224,32 @@ static void test__strtod(void)
     ok(errno == ERANGE, "errno = %x\n", errno);
 }
 
+static void test_float_roundtrip(void)
+{
+    unsigned int i, bits, bits2 = 0;
+    char buf[64];
+    float f, f2;
+
+    /* 9 significant digits are enough to identify every float */
+    for (i = 0; i < 0x10000; i++)
+    {
+        bits = i * 0x10001 + i % 7;
+        memcpy(&f, &bits, sizeof(f));
+        if (!_finite(f)) continue;
+
+        sprintf(buf, "%.9g", f);
+        f2 = strtod(buf, NULL);
+        memcpy(&bits2, &f2, sizeof(f2));
+        if (bits2 != bits) break;
+
+        sprintf(buf, "%.9e", f);
+        f2 = atof(buf);
+        memcpy(&bits2, &f2, sizeof(f2));
+        if (bits2 != bits) break;
+    }
+    ok(i == 0x10000, "%08x: got %08x from %s\n", bits, bits2, buf);
+}
+
 static void test_mbstowcs(void)
 {
     static const wchar_t wSimple[] = L"text";
@@ -4808,8 +4894,10 @@ START_TEST(string)
     test__wcsupr_s();
     test_strtol();
     test_strnlen();
+    test_strlen_strchr_memchr();
     test__strtoi64();
     test__strtod();
+    test_float_roundtrip();
     test_mbstowcs();
     test__wcstombs_s_l();
     test_gcvt();
@@ -2969,7 +2969,14 @@ wchar_t* CDECL wcsrchr(const wchar_t *str, wchar_t ch)
 size_t CDECL wcslen(const wchar_t *str)
 {
     const wchar_t *s = str;
-    while (*s) s++;
+    const uint64_t *p;
+
+    /* misaligned strings never reach block alignment and are scanned here */
+    for (; (uintptr_t)s & (sizeof(uint64_t) - 1); s++)
+        if (!*s) return s - str;
+
+    for (p = (const uint64_t *)s; !((*p - 0x0001000100010001ull) & ~*p & 0x8000800080008000ull); p++);
+    for (s = (const wchar_t *)p; *s; s++);
     return s - str;
 }
 
@@ -469,25 +469,27 @@ static DWORD CALLBACK iocp_poller(LPVOID Arg)
 
     while( TRUE )
     {
-        PRTL_OVERLAPPED_COMPLETION_ROUTINE callback;
-        LPVOID overlapped;
-        IO_STATUS_BLOCK iosb;
-        NTSTATUS res = NtRemoveIoCompletion( cport, (PULONG_PTR)&callback, (PULONG_PTR)&overlapped, &iosb, NULL );
+        FILE_IO_COMPLETION_INFORMATION info[16];
+        ULONG i, count;
+        NTSTATUS res = NtRemoveIoCompletionEx( cport, info, ARRAY_SIZE(info), &count, NULL, FALSE );
         if (res)
         {
-            ERR("NtRemoveIoCompletion failed: 0x%lx\n", res);
+            ERR("NtRemoveIoCompletionEx failed: 0x%lx\n", res);
+            continue;
         }
-        else
+
+        for (i = 0; i < count; i++)
         {
+            PRTL_OVERLAPPED_COMPLETION_ROUTINE callback = (void *)info[i].CompletionKey;
             DWORD transferred = 0;
             DWORD err = 0;
 
-            if (iosb.Status == STATUS_SUCCESS)
-                transferred = iosb.Information;
+            if (info[i].IoStatusBlock.Status == STATUS_SUCCESS)
+                transferred = info[i].IoStatusBlock.Information;
             else
-                err = RtlNtStatusToDosError(iosb.Status);
+                err = RtlNtStatusToDosError(info[i].IoStatusBlock.Status);
 
-            callback( err, transferred, overlapped );
+            callback( err, transferred, (void *)info[i].CompletionValue );
         }
     }
     return 0;
@@ -5357,11 +5357,13 @@ static unsigned int register_async_file_read( HANDLE handle, HANDLE event,
     return status;
 }
 
-void add_completion( HANDLE handle, ULONG_PTR value, NTSTATUS status, ULONG info, BOOL async )
+/* post a completion for the handle; the event, if any, is signaled in the same server call */
+void add_completion( HANDLE handle, ULONG_PTR value, NTSTATUS status, ULONG info, BOOL async, HANDLE event )
 {
     SERVER_START_REQ( add_fd_completion )
     {
         req->handle      = wine_server_obj_handle( handle );
+        req->event       = wine_server_obj_handle( event );
         req->cvalue      = value;
         req->status      = status;
         req->information = info;
@@ -5402,6 +5404,7 @@ NTSTATUS WINAPI NtReadFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, vo
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
     BOOL send_completion = FALSE, async_read, timeout_init_done = FALSE;
+    HANDLE completion_event = NULL;
 
     TRACE( "(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p)\n",
            handle, event, apc, apc_user, io, buffer, (int)length, offset, key );
@@ -5571,7 +5574,8 @@ err:
         io->Status = status;
         io->Information = total;
         TRACE("= SUCCESS (%u)\n", total);
-        if (event) NtSetEvent( event, NULL );
+        if (send_completion) completion_event = event;
+        else if (event) NtSetEvent( event, NULL );
         if (apc && (!status || async_read)) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc,
                                                               (ULONG_PTR)apc_user, iosb_ptr, 0 );
     }
@@ -5584,7 +5588,7 @@ err:
     ret_status = async_read && type == FD_TYPE_FILE && (status == STATUS_SUCCESS || status == STATUS_END_OF_FILE)
             ? STATUS_PENDING : status;
 
-    if (send_completion) add_completion( handle, cvalue, status, total, ret_status == STATUS_PENDING );
+    if (send_completion) add_completion( handle, cvalue, status, total, ret_status == STATUS_PENDING, completion_event );
     return ret_status;
 }
 
@@ -5652,9 +5656,9 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
     io->Status = status;
     io->Information = total;
     TRACE("= 0x%08x (%u)\n", status, total);
-    if (event) NtSetEvent( event, NULL );
+    if (event && !send_completion) NtSetEvent( event, NULL );
     if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc, (ULONG_PTR)apc_user, iosb_ptr, 0 );
-    if (send_completion) add_completion( file, cvalue, status, total, TRUE );
+    if (send_completion) add_completion( file, cvalue, status, total, TRUE, event );
 
     return STATUS_PENDING;
 
@@ -5881,7 +5885,7 @@ err:
         io->Status = status;
         io->Information = total;
         TRACE("= SUCCESS (%u)\n", total);
-        if (event) NtSetEvent( event, NULL );
+        if (event && !send_completion) NtSetEvent( event, NULL );
         if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc, (ULONG_PTR)apc_user, iosb_ptr, 0 );
     }
     else
@@ -5891,7 +5895,8 @@ err:
     }
 
     ret_status = async_write && type == FD_TYPE_FILE && status == STATUS_SUCCESS ? STATUS_PENDING : status;
-    if (send_completion) add_completion( handle, cvalue, status, total, ret_status == STATUS_PENDING );
+    if (send_completion) add_completion( handle, cvalue, status, total, ret_status == STATUS_PENDING,
+                                         status == STATUS_SUCCESS ? event : NULL );
     return ret_status;
 }
 
@@ -5970,7 +5975,7 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         io->Status = status;
         io->Information = total;
         TRACE("= SUCCESS (%u)\n", total);
-        if (event) NtSetEvent( event, NULL );
+        if (event && !send_completion) NtSetEvent( event, NULL );
         if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc, (ULONG_PTR)apc_user, iosb_ptr, 0 );
     }
     else
@@ -5978,7 +5983,7 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         TRACE("= 0x%08x\n", status);
         if (status != STATUS_PENDING && event) NtResetEvent( event, NULL );
     }
-    if (send_completion) add_completion( file, cvalue, status, total, FALSE );
+    if (send_completion) add_completion( file, cvalue, status, total, FALSE, status == STATUS_SUCCESS ? event : NULL );
     return status;
 }
 
@@ -1397,6 +1397,7 @@ static NTSTATUS open_main_image( WCHAR *image, void **module, SECTION_IMAGE_INFO
     status = open_dll_file( unix_name, &attr, &mapping );
     if (!status)
     {
+        virtual_init_prefetch( unix_name );
         status = virtual_map_module( mapping, module, &size, info, 0, 0, machine );
         if (status == STATUS_IMAGE_MACHINE_TYPE_MISMATCH && info->ComPlusNativeReady)
         {
@@ -1002,7 +1002,11 @@ NTSTATUS WINAPI NtTerminateProcess( HANDLE handle, LONG exit_code )
     SERVER_END_REQ;
     if (self)
     {
-        if (!handle) process_exiting = TRUE;
+        if (!handle)
+        {
+            process_exiting = TRUE;
+            virtual_save_prefetch();
+        }
         else if (process_exiting) exit_process( exit_code );
         else abort_process( exit_code );
     }
@@ -39,6 +39,9 @@
 # define __APPLE_USE_RFC_3542
 # include <netinet/in.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 #ifdef HAVE_NETINET_TCP_H
 # include <netinet/tcp.h>
 #endif
@@ -151,6 +154,7 @@ struct async_transmit_ioctl
     unsigned int head_len;
     unsigned int tail_len;
     LARGE_INTEGER offset;
+    BOOL use_sendfile;          /* try to send file data directly with sendfile() */
 };
 
 static NTSTATUS sock_errno_to_status( int err )
@@ -1219,7 +1223,7 @@ NTSTATUS sock_write( HANDLE handle, int fd, HANDLE event, PIO_APC_ROUTINE apc,
     static const DWORD async_size = offsetof( struct async_send_ioctl, iov[1] );
     struct async_send_ioctl *async;
 
-    if (!(async = (struct async_send_ioctl *)alloc_fileio( async_size, async_recv_proc, handle )))
+    if (!(async = (struct async_send_ioctl *)alloc_fileio( async_size, async_send_proc, handle )))
         return STATUS_NO_MEMORY;
 
     async->count = 1;
@@ -1268,6 +1272,40 @@ static NTSTATUS try_transmit( int sock_fd, int file_fd, struct async_transmit_io
         async->file_cursor += ret;
     }
 
+#ifdef HAVE_SYS_SENDFILE_H
+    if (async->file && async->use_sendfile)
+    {
+        size_t count = async->file_len ? async->file_len - async->file_cursor : 0x7ffff000;
+        off_t offset = async->offset.QuadPart;
+
+        TRACE( "sending %zu bytes of file data with sendfile\n", count );
+        do
+        {
+            if (async->offset.QuadPart == FILE_USE_FILE_POINTER_POSITION)
+                ret = sendfile( sock_fd, file_fd, NULL, count );
+            else
+                ret = sendfile( sock_fd, file_fd, &offset, count );
+        } while (ret < 0 && errno == EINTR);
+
+        if (ret >= 0)
+        {
+            TRACE( "sendfile returned %zd\n", ret );
+            async->file_cursor += ret;
+            if (async->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+                async->offset.QuadPart += ret;
+
+            if (!ret || (async->file_len && async->file_cursor == async->file_len))
+                async->file = NULL;
+            return STATUS_DEVICE_NOT_READY; /* still more data to send */
+        }
+        if (errno != EINVAL && errno != ENOSYS) return sock_errno_to_status( errno );
+
+        /* not supported for this file, fall back to copying the data */
+        TRACE( "sendfile failed: %s\n", strerror( errno ));
+        async->use_sendfile = FALSE;
+    }
+#endif
+
     if (async->file && async->buffer_cursor == async->read_len)
     {
         unsigned int read_size = async->buffer_size;
@@ -1392,6 +1430,7 @@ static NTSTATUS sock_transmit( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc,
     async->tail = u64_to_user_ptr(params->tail_ptr);
     async->tail_len = params->tail_len;
     async->offset = params->offset;
+    async->use_sendfile = TRUE;
 
     SERVER_START_REQ( send_socket )
     {
@@ -1448,7 +1487,7 @@ static void complete_async( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, vo
     io->Information = information;
     if (event) NtSetEvent( event, NULL );
     if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc, (ULONG_PTR)apc_user, iosb_ptr, 0 );
-    if (apc_user) add_completion( handle, (ULONG_PTR)apc_user, status, information, FALSE );
+    if (apc_user) add_completion( handle, (ULONG_PTR)apc_user, status, information, FALSE, NULL );
 }
 
 
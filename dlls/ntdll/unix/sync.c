@@ -1884,6 +1884,7 @@ NTSTATUS WINAPI NtSetIoCompletion( HANDLE handle, ULONG_PTR key, ULONG_PTR value
 NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *value,
                                       IO_STATUS_BLOCK *io, LARGE_INTEGER *timeout )
 {
+    struct completion_info msg;
     unsigned int status;
 
     TRACE( "(%p, %p, %p, %p, %p)\n", handle, key, value, io, timeout );
@@ -1893,12 +1894,13 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *
         SERVER_START_REQ( remove_completion )
         {
             req->handle = wine_server_obj_handle( handle );
+            wine_server_set_reply( req, &msg, sizeof(msg) );
             if (!(status = wine_server_call( req )))
             {
-                *key            = reply->ckey;
-                *value          = reply->cvalue;
-                io->Information = reply->information;
-                io->Status      = reply->status;
+                *key            = msg.ckey;
+                *value          = msg.cvalue;
+                io->Information = msg.information;
+                io->Status      = msg.status;
             }
         }
         SERVER_END_REQ;
@@ -1915,29 +1917,37 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *
 NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE handle, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
                                         ULONG *written, LARGE_INTEGER *timeout, BOOLEAN alertable )
 {
+    struct completion_info msgs[64];
     unsigned int status;
-    ULONG i = 0;
+    ULONG i = 0, j, n;
 
     TRACE( "%p %p %u %p %p %u\n", handle, info, (int)count, written, timeout, alertable );
 
     for (;;)
     {
+        /* dequeue as many messages as possible in each server call */
         while (i < count)
         {
+            n = min( count - i, ARRAY_SIZE(msgs) );
             SERVER_START_REQ( remove_completion )
             {
                 req->handle = wine_server_obj_handle( handle );
+                wine_server_set_reply( req, msgs, n * sizeof(*msgs) );
                 if (!(status = wine_server_call( req )))
-                {
-                    info[i].CompletionKey             = reply->ckey;
-                    info[i].CompletionValue           = reply->cvalue;
-                    info[i].IoStatusBlock.Information = reply->information;
-                    info[i].IoStatusBlock.Status      = reply->status;
-                }
+                    n = wine_server_reply_size( reply ) / sizeof(*msgs);
             }
             SERVER_END_REQ;
             if (status != STATUS_SUCCESS) break;
-            ++i;
+
+            for (j = 0; j < n; j++, i++)
+            {
+                info[i].CompletionKey             = msgs[j].ckey;
+                info[i].CompletionValue           = msgs[j].cvalue;
+                info[i].IoStatusBlock.Information = msgs[j].information;
+                info[i].IoStatusBlock.Status      = msgs[j].status;
+            }
+            /* a short reply means that the queue is empty now */
+            if (i < count && n < ARRAY_SIZE(msgs)) break;
         }
         if (i || status != STATUS_PENDING)
         {
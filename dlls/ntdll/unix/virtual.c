@@ -54,6 +54,12 @@
 #ifdef HAVE_LIBPROCSTAT_H
 # include <libprocstat.h>
 #endif
+#ifdef HAVE_LINUX_USERFAULTFD_H
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <linux/fs.h>
+# include <linux/userfaultfd.h>
+#endif
 #include <unistd.h>
 #include <dlfcn.h>
 #ifdef HAVE_VALGRIND_VALGRIND_H
@@ -105,6 +111,9 @@ struct builtin_module
 };
 
 static struct list builtin_modules = LIST_INIT( builtin_modules );
+/* protects the builtin modules list, may be taken while holding virtual_mutex but not the reverse;
+ * not held across dlopen() or dlclose(), library constructors may fault or call back into ntdll */
+static pthread_mutex_t builtin_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 struct file_view
 {
@@ -127,6 +136,7 @@ struct file_view
 #define VPROT_SYSTEM           0x0200  /* system view (underlying mmap not under our control) */
 #define VPROT_PLACEHOLDER      0x0400
 #define VPROT_FREE_PLACEHOLDER 0x0800
+#define VPROT_KERNEL_WRITEWATCH 0x1000 /* write watches tracked by the kernel */
 
 /* Conversion from VPROT_* to Win32 flags */
 static const BYTE VIRTUAL_Win32Flags[16] =
@@ -155,6 +165,7 @@ static pthread_mutex_t virtual_mutex;
 static const UINT page_shift = 12;
 static const UINT_PTR page_mask = 0xfff;
 static const UINT_PTR granularity_mask = 0xffff;
+static const UINT_PTR large_page_mask = 0x1fffff;  /* must match LargePageMinimum in the user shared data */
 
 /* Note: these are Windows limits, you cannot change them. */
 #ifdef __i386__
@@ -184,6 +195,8 @@ static void *teb_block;
 static void **next_free_teb;
 static int teb_block_pos;
 static struct list teb_list = LIST_INIT( teb_list );
+/* protects the TEB allocation blocks and list, may be held while calling virtual memory functions */
+static pthread_mutex_t teb_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 #define ROUND_ADDR(addr,mask) ((void *)((UINT_PTR)(addr) & ~(UINT_PTR)(mask)))
 #define ROUND_SIZE(addr,size) (((SIZE_T)(size) + ((UINT_PTR)(addr) & page_mask) + page_mask) & ~page_mask)
@@ -210,6 +223,38 @@ static void *preload_reserve_start;
 static void *preload_reserve_end;
 static BOOL force_exec_prot;  /* whether to force PROT_EXEC on all PROT_READ mmaps */
 
+#if defined(HAVE_LINUX_USERFAULTFD_H) && defined(UFFD_FEATURE_WP_ASYNC) && defined(PAGEMAP_SCAN)
+static BOOL use_kernel_writewatch;  /* whether write watches are tracked by the kernel */
+static int uffd_fd = -1;
+static int wp_pagemap_fd = -1;
+#endif
+
+/* startup prefetch profile: file ranges of the images used during the first seconds of the process */
+struct prefetch_range
+{
+    UINT rva;                         /* offset of the range in the view */
+    UINT size;                        /* size of the range */
+    UINT offset;                      /* offset of the range in the file */
+};
+
+struct prefetch_image
+{
+    void                 *base;       /* view base address */
+    WCHAR                *name;       /* NT file name */
+    BOOL                  relocated;  /* mapped from the server relocated copy */
+    unsigned int          count;      /* number of ranges */
+    struct prefetch_range ranges[1];
+};
+
+static char *prefetch_profile;        /* profile file name, NULL when not recording */
+static struct prefetch_image **prefetch_images;
+static unsigned int prefetch_count;
+static LONGLONG prefetch_start_time;  /* start of the recording period */
+static LONGLONG prefetch_last_time;   /* time the last recorded image was mapped */
+static LONGLONG prefetch_end_time;    /* end of the recording period */
+static const unsigned int prefetch_max_images = 512;
+static const LONGLONG prefetch_duration = 10 * (LONGLONG)TICKSPERSEC;
+
 struct range_entry
 {
     void *base;
@@ -583,7 +628,9 @@ static void add_builtin_module( void *module, void *handle )
     builtin->refcount    = 1;
     builtin->unix_path   = NULL;
     builtin->unix_handle = NULL;
+    mutex_lock( &builtin_mutex );
     list_add_tail( &builtin_modules, &builtin->entry );
+    mutex_unlock( &builtin_mutex );
 }
 
 
@@ -592,21 +639,26 @@ static void add_builtin_module( void *module, void *handle )
  */
 static void release_builtin_module( void *module )
 {
-    struct builtin_module *builtin;
+    struct builtin_module *builtin, *released = NULL;
 
+    mutex_lock( &builtin_mutex );
     LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
     {
         if (builtin->module != module) continue;
         if (!--builtin->refcount)
         {
             list_remove( &builtin->entry );
-            if (builtin->handle) dlclose( builtin->handle );
-            if (builtin->unix_handle) dlclose( builtin->unix_handle );
-            free( builtin->unix_path );
-            free( builtin );
+            released = builtin;
         }
         break;
     }
+    mutex_unlock( &builtin_mutex );
+
+    if (!released) return;
+    if (released->handle) dlclose( released->handle );
+    if (released->unix_handle) dlclose( released->unix_handle );
+    free( released->unix_path );
+    free( released );
 }
 
 
@@ -619,7 +671,7 @@ void *get_builtin_so_handle( void *module )
     void *ret = NULL;
     struct builtin_module *builtin;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    server_enter_uninterrupted_section( &builtin_mutex, &sigset );
     LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
     {
         if (builtin->module != module) continue;
@@ -627,7 +679,7 @@ void *get_builtin_so_handle( void *module )
         if (ret) builtin->refcount++;
         break;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    server_leave_uninterrupted_section( &builtin_mutex, &sigset );
     return ret;
 }
 
@@ -641,13 +693,33 @@ static NTSTATUS get_builtin_unix_funcs( void *module, BOOL wow, const void **fun
     sigset_t sigset;
     NTSTATUS status = STATUS_DLL_NOT_FOUND;
     struct builtin_module *builtin;
+    char *unix_path = NULL;
+    void *handle = NULL;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    server_enter_uninterrupted_section( &builtin_mutex, &sigset );
     LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
     {
         if (builtin->module != module) continue;
-        if (builtin->unix_path && !builtin->unix_handle)
-            builtin->unix_handle = dlopen( builtin->unix_path, RTLD_NOW );
+        if (builtin->unix_path && !builtin->unix_handle) unix_path = strdup( builtin->unix_path );
+        break;
+    }
+    server_leave_uninterrupted_section( &builtin_mutex, &sigset );
+
+    if (unix_path)
+    {
+        handle = dlopen( unix_path, RTLD_NOW );
+        free( unix_path );
+    }
+
+    server_enter_uninterrupted_section( &builtin_mutex, &sigset );
+    LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
+    {
+        if (builtin->module != module) continue;
+        if (!builtin->unix_handle)
+        {
+            builtin->unix_handle = handle;
+            handle = NULL;
+        }
         if (builtin->unix_handle)
         {
             *funcs = dlsym( builtin->unix_handle, ptr_name );
@@ -655,7 +727,10 @@ static NTSTATUS get_builtin_unix_funcs( void *module, BOOL wow, const void **fun
         }
         break;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    server_leave_uninterrupted_section( &builtin_mutex, &sigset );
+
+    /* another thread loaded it first, or the module is gone */
+    if (handle) dlclose( handle );
     return status;
 }
 
@@ -669,7 +744,7 @@ NTSTATUS load_builtin_unixlib( void *module, const char *name )
     NTSTATUS status = STATUS_SUCCESS;
     struct builtin_module *builtin;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    server_enter_uninterrupted_section( &builtin_mutex, &sigset );
     LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
     {
         if (builtin->module != module) continue;
@@ -677,7 +752,7 @@ NTSTATUS load_builtin_unixlib( void *module, const char *name )
         else status = STATUS_IMAGE_ALREADY_LOADED;
         break;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    server_leave_uninterrupted_section( &builtin_mutex, &sigset );
     return status;
 }
 
@@ -1556,6 +1631,208 @@ static void register_view( struct file_view *view )
 }
 
 
+#if defined(HAVE_LINUX_USERFAULTFD_H) && defined(UFFD_FEATURE_WP_ASYNC) && defined(PAGEMAP_SCAN)
+
+/***********************************************************************
+ *           kernel_writewatch_init
+ *
+ * Check if the kernel can track written pages for us, using userfaultfd
+ * asynchronous write-protect mode together with the pagemap scan ioctl.
+ * This is done on the first write watch allocation.
+ * virtual_mutex must be held by caller.
+ */
+static BOOL kernel_writewatch_init(void)
+{
+    static BOOL initialized;
+    struct uffdio_api uffdio_api;
+
+    if (initialized) return use_kernel_writewatch;
+    initialized = TRUE;
+
+    if ((uffd_fd = syscall( __NR_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY )) == -1)
+        return FALSE;
+
+    uffdio_api.api = UFFD_API;
+    uffdio_api.features = UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED;
+    if (ioctl( uffd_fd, UFFDIO_API, &uffdio_api ) == -1 || uffdio_api.api != UFFD_API ||
+        (uffdio_api.features & (UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED)) !=
+        (UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED))
+        goto failed;
+
+    if ((wp_pagemap_fd = open( "/proc/self/pagemap", O_RDONLY | O_CLOEXEC )) == -1) goto failed;
+
+    TRACE( "using kernel write watches\n" );
+    use_kernel_writewatch = TRUE;
+    return TRUE;
+
+failed:
+    close( uffd_fd );
+    uffd_fd = -1;
+    return FALSE;
+}
+
+
+/***********************************************************************
+ *           kernel_writewatch_protect
+ *
+ * Write-protect a range, so that the next write to each page gets recorded.
+ */
+static void kernel_writewatch_protect( void *base, size_t size )
+{
+    struct uffdio_writeprotect wp;
+
+    if (!size) return;
+    wp.range.start = (UINT_PTR)base;
+    wp.range.len = size;
+    wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+    if (ioctl( uffd_fd, UFFDIO_WRITEPROTECT, &wp ) == -1)
+        ERR( "UFFDIO_WRITEPROTECT failed for %p-%p: %s\n", base, (char *)base + size, strerror(errno) );
+}
+
+
+/***********************************************************************
+ *           kernel_writewatch_register
+ *
+ * Register a range with userfaultfd, optionally write-protecting it.
+ */
+static BOOL kernel_writewatch_register( void *base, size_t size, BOOL protect )
+{
+    struct uffdio_register uffdio_register;
+
+    uffdio_register.range.start = (UINT_PTR)base;
+    uffdio_register.range.len = size;
+    uffdio_register.mode = UFFDIO_REGISTER_MODE_WP;
+    if (ioctl( uffd_fd, UFFDIO_REGISTER, &uffdio_register ) == -1)
+    {
+        ERR( "UFFDIO_REGISTER failed for %p-%p: %s\n", base, (char *)base + size, strerror(errno) );
+        return FALSE;
+    }
+    if (protect) kernel_writewatch_protect( base, size );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           kernel_writewatch_scan
+ *
+ * Retrieve the pages written to since the last reset, optionally
+ * write-protecting them again in the same call.
+ */
+static void kernel_writewatch_scan( char *base, char *end, void **addresses, ULONG_PTR *count, BOOL reset )
+{
+    struct page_region regions[64];
+    struct pm_scan_arg arg;
+    ULONG_PTR pos = 0;
+    char *addr = base;
+    int i, ret;
+
+    memset( &arg, 0, sizeof(arg) );
+    arg.size = sizeof(arg);
+    arg.flags = reset ? PM_SCAN_WP_MATCHING : 0;
+    arg.vec = (UINT_PTR)regions;
+    arg.vec_len = ARRAY_SIZE(regions);
+    arg.category_mask = PAGE_IS_WRITTEN;
+    arg.return_mask = PAGE_IS_WRITTEN;
+
+    while (addr < end && (!addresses || pos < *count))
+    {
+        arg.start = (UINT_PTR)addr;
+        arg.end = (UINT_PTR)end;
+        arg.max_pages = addresses ? *count - pos : 0;
+        if ((ret = ioctl( wp_pagemap_fd, PAGEMAP_SCAN, &arg )) < 0)
+        {
+            ERR( "PAGEMAP_SCAN failed for %p-%p: %s\n", addr, end, strerror(errno) );
+            break;
+        }
+        if (addresses)
+        {
+            for (i = 0; i < ret; i++)
+            {
+                char *page = (char *)(UINT_PTR)regions[i].start;
+                while (page < (char *)(UINT_PTR)regions[i].end && pos < *count)
+                {
+                    addresses[pos++] = page;
+                    page += page_size;
+                }
+            }
+        }
+        addr = (char *)(UINT_PTR)arg.walk_end;
+    }
+    if (count) *count = pos;
+}
+
+
+/***********************************************************************
+ *           kernel_writewatch_decommit
+ *
+ * Replace a range by a new inaccessible mapping. The new mapping is no longer
+ * registered with userfaultfd, so register it again and write-protect only
+ * the pages that haven't been written to since the last reset.
+ */
+static BOOL kernel_writewatch_decommit( char *base, size_t size )
+{
+    struct page_region regions[64];
+    struct pm_scan_arg arg;
+    char *addr = base, *end = base + size, *chunk_end, *prev;
+    int i, ret;
+
+    memset( &arg, 0, sizeof(arg) );
+    arg.size = sizeof(arg);
+    arg.vec = (UINT_PTR)regions;
+    arg.vec_len = ARRAY_SIZE(regions);
+    arg.category_mask = PAGE_IS_WRITTEN;
+    arg.return_mask = PAGE_IS_WRITTEN;
+
+    while (addr < end)
+    {
+        arg.start = (UINT_PTR)addr;
+        arg.end = (UINT_PTR)end;
+        if ((ret = ioctl( wp_pagemap_fd, PAGEMAP_SCAN, &arg )) < 0)
+        {
+            ERR( "PAGEMAP_SCAN failed for %p-%p: %s\n", addr, end, strerror(errno) );
+            ret = 0;
+            arg.walk_end = (UINT_PTR)end;
+        }
+        chunk_end = (char *)(UINT_PTR)arg.walk_end;
+        if (anon_mmap_fixed( addr, chunk_end - addr, PROT_NONE, 0 ) == MAP_FAILED) return FALSE;
+        if (kernel_writewatch_register( addr, chunk_end - addr, FALSE ))
+        {
+            for (i = 0, prev = addr; i < ret; i++)
+            {
+                kernel_writewatch_protect( prev, (char *)(UINT_PTR)regions[i].start - prev );
+                prev = (char *)(UINT_PTR)regions[i].end;
+            }
+            kernel_writewatch_protect( prev, chunk_end - prev );
+        }
+        addr = chunk_end;
+    }
+    return TRUE;
+}
+
+#else
+
+static BOOL kernel_writewatch_init(void)
+{
+    return FALSE;
+}
+
+static BOOL kernel_writewatch_register( void *base, size_t size, BOOL protect )
+{
+    return FALSE;
+}
+
+static void kernel_writewatch_scan( char *base, char *end, void **addresses, ULONG_PTR *count, BOOL reset )
+{
+}
+
+static BOOL kernel_writewatch_decommit( char *base, size_t size )
+{
+    return FALSE;
+}
+
+#endif
+
+
 /***********************************************************************
  *           create_view
  *
@@ -1594,6 +1871,18 @@ static NTSTATUS create_view( struct file_view **view_ret, void *base, size_t siz
     view->base    = base;
     view->size    = size;
     view->protect = vprot;
+    if ((vprot & VPROT_WRITEWATCH) && kernel_writewatch_init())
+    {
+        /* the kernel tracks written pages, pages don't need the write watch flag */
+        mprotect( base, size, get_unix_prot( vprot & ~VPROT_WRITEWATCH ));
+        if (kernel_writewatch_register( base, size, TRUE ))
+        {
+            view->protect |= VPROT_KERNEL_WRITEWATCH;
+            vprot &= ~VPROT_WRITEWATCH;
+        }
+        else mprotect( base, size, unix_prot );  /* fall back to catching write faults */
+        unix_prot = get_unix_prot( vprot );
+    }
     set_page_vprot( base, size, vprot );
 
     register_view( view );
@@ -1799,8 +2088,13 @@ static void update_write_watches( void *base, size_t size, size_t accessed_size
  *
  * Reset write watches in a memory range.
  */
-static void reset_write_watches( void *base, SIZE_T size )
+static void reset_write_watches( struct file_view *view, void *base, SIZE_T size )
 {
+    if (view->protect & VPROT_KERNEL_WRITEWATCH)
+    {
+        kernel_writewatch_scan( base, (char *)base + size, NULL, NULL, TRUE );
+        return;
+    }
     set_page_vprot_bits( base, size, VPROT_WRITEWATCH, 0 );
     mprotect_range( base, size, 0, 0 );
 }
@@ -1992,7 +2286,13 @@ static NTSTATUS map_view( struct file_view **view_ret, void *base, size_t size,
 
         view->protect = vprot | VPROT_PLACEHOLDER;
         set_vprot( view, base, size, vprot );
-        if (vprot & VPROT_WRITEWATCH) reset_write_watches( base, size );
+        if (vprot & VPROT_WRITEWATCH)
+        {
+            if (kernel_writewatch_init() && kernel_writewatch_register( base, size, TRUE ))
+                view->protect |= VPROT_KERNEL_WRITEWATCH;
+            else
+                reset_write_watches( view, base, size );
+        }
         *view_ret = view;
         return STATUS_SUCCESS;
     }
@@ -2185,8 +2485,14 @@ static SIZE_T get_committed_size( struct file_view *view, void *base, BYTE *vpro
  */
 static NTSTATUS decommit_pages( struct file_view *view, size_t start, size_t size )
 {
+    BOOL ret;
+
     if (!size) size = view->size;
-    if (anon_mmap_fixed( (char *)view->base + start, size, PROT_NONE, 0 ) != MAP_FAILED)
+    if (view->protect & VPROT_KERNEL_WRITEWATCH)
+        ret = kernel_writewatch_decommit( (char *)view->base + start, size );
+    else
+        ret = anon_mmap_fixed( (char *)view->base + start, size, PROT_NONE, 0 ) != MAP_FAILED;
+    if (ret)
     {
         set_page_vprot_bits( (char *)view->base + start, size, 0, VPROT_COMMITTED );
         return STATUS_SUCCESS;
@@ -2697,11 +3003,12 @@ static IMAGE_BASE_RELOCATION *process_relocation_block( char *page, IMAGE_BASE_R
  *           map_image_into_view
  *
  * Map an executable (PE format) image into an existing view.
+ * If reloc_fd is valid, it contains the image already relocated to the view address.
  * virtual_mutex must be held by caller.
  */
 static NTSTATUS map_image_into_view( struct file_view *view, const WCHAR *filename, int fd,
                                      pe_image_info_t *image_info, USHORT machine,
-                                     int shared_fd, BOOL removable )
+                                     int shared_fd, int reloc_fd, BOOL removable )
 {
     IMAGE_DOS_HEADER *dos;
     IMAGE_NT_HEADERS *nt;
@@ -2723,13 +3030,20 @@ static NTSTATUS map_image_into_view( struct file_view *view, const WCHAR *filena
 
     fstat( fd, &st );
     header_size = min( image_info->header_size, st.st_size );
-    if ((status = map_pe_header( view->base, header_size, fd, &removable ))) return status;
+    if (reloc_fd != -1)
+    {
+        /* the server did the section layout and relocations, map the whole thing at once */
+        if ((status = map_file_into_view( view, reloc_fd, 0, total_size, 0,
+                                          VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY, FALSE )))
+            return status;
+    }
+    else if ((status = map_pe_header( view->base, header_size, fd, &removable ))) return status;
 
     status = STATUS_INVALID_IMAGE_FORMAT;  /* generic error */
     dos = (IMAGE_DOS_HEADER *)ptr;
     nt = (IMAGE_NT_HEADERS *)(ptr + dos->e_lfanew);
     header_end = ptr + ROUND_SIZE( 0, header_size );
-    memset( ptr + header_size, 0, header_end - (ptr + header_size) );
+    if (reloc_fd == -1) memset( ptr + header_size, 0, header_end - (ptr + header_size) );
     if ((char *)(nt + 1) > header_end) return status;
     if (nt->FileHeader.NumberOfSections > ARRAY_SIZE( sections )) return status;
     sec = IMAGE_FIRST_SECTION( nt );
@@ -2828,7 +3142,7 @@ static NTSTATUS map_image_into_view( struct file_view *view, const WCHAR *filena
                         (int)sec->PointerToRawData, (int)sec->SizeOfRawData,
                         (int)sec->Misc.VirtualSize, (int)sec->Characteristics );
 
-        if (!sec->PointerToRawData || !file_size) continue;
+        if (!sec->PointerToRawData || !file_size || reloc_fd != -1) continue;
 
         /* Note: if the section is not aligned properly map_file_into_view will magically
          *       fall back to read(), so we don't need to check anything here.
@@ -2876,7 +3190,7 @@ static NTSTATUS map_image_into_view( struct file_view *view, const WCHAR *filena
 
     /* relocate to dynamic base */
 
-    if (image_info->map_addr && (delta = image_info->map_addr - image_info->base))
+    if (reloc_fd == -1 && image_info->map_addr && (delta = image_info->map_addr - image_info->base))
     {
         TRACE_(module)( "relocating %s dynamic base %lx -> %lx mapped at %p\n", debugstr_w(filename),
                         (ULONG_PTR)image_info->base, (ULONG_PTR)image_info->map_addr, ptr );
@@ -2931,7 +3245,8 @@ static NTSTATUS map_image_into_view( struct file_view *view, const WCHAR *filena
  *             get_mapping_info
  */
 static unsigned int get_mapping_info( HANDLE handle, ACCESS_MASK access, unsigned int *sec_flags,
-                                      mem_size_t *full_size, HANDLE *shared_file, pe_image_info_t **info )
+                                      mem_size_t *full_size, HANDLE *shared_file, HANDLE *relocated_file,
+                                      pe_image_info_t **info )
 {
     pe_image_info_t *image_info;
     SIZE_T total, size = 1024;
@@ -2951,12 +3266,14 @@ static unsigned int get_mapping_info( HANDLE handle, ACCESS_MASK access, unsigne
             *full_size   = reply->size;
             total        = reply->total;
             *shared_file = wine_server_ptr_handle( reply->shared_file );
+            *relocated_file = wine_server_ptr_handle( reply->relocated_file );
         }
         SERVER_END_REQ;
         if (!status && total <= size - sizeof(WCHAR)) break;
         free( image_info );
         if (status) return status;
         if (*shared_file) NtClose( *shared_file );
+        if (*relocated_file) NtClose( *relocated_file );
         size = total + sizeof(WCHAR);
     }
 
@@ -3035,21 +3352,292 @@ static NTSTATUS map_image_view( struct file_view **view_ret, pe_image_info_t *im
 }
 
 
+/***********************************************************************
+ *           replay_prefetch_profile
+ *
+ * Start reading ahead the file ranges recorded in a prefetch profile.
+ */
+static void replay_prefetch_profile( const char *profile )
+{
+#ifdef HAVE_POSIX_FADVISE
+    char line[4096], *path, *end, *cur = NULL;
+    unsigned int offset, size, count = 0;
+    int fd = -1;
+    FILE *f;
+
+    if (!(f = fopen( profile, "r" ))) return;
+    while (fgets( line, sizeof(line), f ))
+    {
+        offset = strtoul( line, &end, 16 );
+        size = strtoul( end, &path, 16 );
+        if (*path++ != ' ' || !(end = strchr( path, '\n' ))) continue;
+        *end = 0;
+        if (!cur || strcmp( cur, path ))
+        {
+            if (fd != -1) close( fd );
+            free( cur );
+            cur = strdup( path );
+            fd = open( path, O_RDONLY );
+        }
+        if (fd == -1) continue;
+        posix_fadvise( fd, offset, size, POSIX_FADV_WILLNEED );
+        count++;
+    }
+    if (fd != -1) close( fd );
+    free( cur );
+    fclose( f );
+    TRACE( "%s: started readahead of %u ranges\n", debugstr_a(profile), count );
+#endif
+}
+
+
+/***********************************************************************
+ *           virtual_init_prefetch
+ *
+ * Replay the prefetch profile of the main image, and start recording a new one.
+ */
+void virtual_init_prefetch( const char *unix_name )
+{
+    static const char dir[] = "/prefetch/";
+    const char *p, *base = unix_name;
+    const char *env = getenv( "WINEPREFETCH" );
+    unsigned int hash = 2166136261u;
+    LARGE_INTEGER now;
+    char *profile;
+
+    if (prefetch_images || !config_dir) return;
+    if (env && !atoi( env )) return;
+
+    for (p = unix_name; *p; p++)
+    {
+        hash = (hash ^ (unsigned char)*p) * 16777619;
+        if (*p == '/') base = p + 1;
+    }
+    if (!(profile = malloc( strlen(config_dir) + sizeof(dir) + strlen(base) + sizeof("-12345678.pf") )))
+        return;
+    sprintf( profile, "%s%s%s-%08X.pf", config_dir, dir, base, hash );
+    if (!(prefetch_images = calloc( prefetch_max_images, sizeof(*prefetch_images) )))
+    {
+        free( profile );
+        return;
+    }
+
+    NtQueryPerformanceCounter( &now, NULL );
+    prefetch_start_time = prefetch_last_time = now.QuadPart;
+
+    replay_prefetch_profile( profile );
+
+    NtQueryPerformanceCounter( &now, NULL );
+    TRACE( "%s: replay took %u ms\n", debugstr_a(profile),
+           (unsigned int)((now.QuadPart - prefetch_start_time) / (TICKSPERSEC / 1000)) );
+    prefetch_end_time = now.QuadPart + prefetch_duration;
+    prefetch_profile = profile;
+}
+
+
+/***********************************************************************
+ *           record_prefetch_image
+ *
+ * Add a newly mapped image to the prefetch profile.
+ * virtual_mutex must be held by caller.
+ * Returns FALSE once the recording period is over.
+ */
+static BOOL record_prefetch_image( struct file_view *view, const WCHAR *filename,
+                                   const pe_image_info_t *image_info, BOOL relocated )
+{
+    static const UINT sector_align = 0x1ff;
+    const IMAGE_DOS_HEADER *dos = view->base;
+    const IMAGE_NT_HEADERS *nt;
+    const IMAGE_SECTION_HEADER *sec;
+    struct prefetch_image *image;
+    LARGE_INTEGER now;
+    UINT i, map_size, file_size;
+
+    if (!prefetch_profile) return TRUE;
+    NtQueryPerformanceCounter( &now, NULL );
+    if (now.QuadPart > prefetch_end_time) return FALSE;
+    if (prefetch_count >= prefetch_max_images) return TRUE;
+    if (image_info->image_flags & IMAGE_FLAGS_ImageMappedFlat) return TRUE;
+    prefetch_last_time = now.QuadPart;
+
+    /* the headers have been validated by map_image_into_view() */
+    nt = (const IMAGE_NT_HEADERS *)((const char *)view->base + dos->e_lfanew);
+    sec = IMAGE_FIRST_SECTION( nt );
+    if (!(image = malloc( offsetof( struct prefetch_image, ranges[nt->FileHeader.NumberOfSections + 1] ))))
+        return TRUE;
+    if (!(image->name = malloc( (wcslen( filename ) + 1) * sizeof(WCHAR) )))
+    {
+        free( image );
+        return TRUE;
+    }
+    wcscpy( image->name, filename );
+    image->base = view->base;
+    image->relocated = relocated;
+    image->ranges[0].rva = 0;
+    image->ranges[0].size = image_info->header_size;
+    image->ranges[0].offset = 0;
+    image->count = 1;
+
+    for (i = 0; i < nt->FileHeader.NumberOfSections; i++, sec++)
+    {
+        if ((sec->Characteristics & IMAGE_SCN_MEM_SHARED) && (sec->Characteristics & IMAGE_SCN_MEM_WRITE))
+            continue;
+        if (!sec->PointerToRawData || !sec->SizeOfRawData) continue;
+        map_size = ROUND_SIZE( 0, sec->Misc.VirtualSize ? sec->Misc.VirtualSize : sec->SizeOfRawData );
+        file_size = (sec->SizeOfRawData + (sec->PointerToRawData & sector_align) + sector_align) & ~sector_align;
+        image->ranges[image->count].rva = sec->VirtualAddress;
+        image->ranges[image->count].size = min( file_size, map_size );
+        image->ranges[image->count].offset = sec->PointerToRawData & ~sector_align;
+        image->count++;
+    }
+    prefetch_images[prefetch_count++] = image;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           get_prefetch_range_pages
+ *
+ * Find which pages of a recorded range have been used.
+ */
+static BOOL get_prefetch_range_pages( struct prefetch_image *image, struct prefetch_range *range,
+                                      unsigned char *vec, UINT pages )
+{
+    struct file_view *view;
+    sigset_t sigset;
+    BOOL valid;
+
+    /* the view maps the server's relocated copy, which was built by reading the whole range */
+    if (image->relocated)
+    {
+        memset( vec, 1, pages );
+        return TRUE;
+    }
+
+    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    valid = ((view = find_view( image->base, 0 )) && view->base == image->base &&
+             (view->protect & SEC_IMAGE) && range->rva + range->size <= view->size);
+#ifdef HAVE_MINCORE
+    if (valid && mincore( (char *)image->base + range->rva, pages << page_shift, (void *)vec ))
+        valid = FALSE;
+#else
+    if (valid) memset( vec, 1, pages );
+#endif
+    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    return valid;
+}
+
+
+/***********************************************************************
+ *           write_prefetch_image
+ *
+ * Write the resident ranges of a recorded image to the profile.
+ */
+static unsigned int write_prefetch_image( FILE *f, struct prefetch_image *image )
+{
+    UNICODE_STRING nt_name;
+    OBJECT_ATTRIBUTES attr;
+    unsigned char *vec;
+    char *unix_name;
+    UINT i, pages, start, end, total = 0;
+    BOOL valid;
+
+    init_unicode_string( &nt_name, image->name );
+    InitializeObjectAttributes( &attr, &nt_name, OBJ_CASE_INSENSITIVE, 0, NULL );
+    if (nt_to_unix_file_name( &attr, &unix_name, FILE_OPEN )) return 0;
+
+    for (i = 0; i < image->count; i++)
+    {
+        struct prefetch_range *range = &image->ranges[i];
+
+        pages = ROUND_SIZE( 0, range->size ) >> page_shift;
+        if (!pages || !(vec = calloc( pages, 1 ))) continue;
+
+        valid = get_prefetch_range_pages( image, range, vec, pages );
+        for (start = 0; valid && start < pages; start = end)
+        {
+            for (end = start; end < pages && (vec[end] & 1); end++) ;
+            if (end > start)
+            {
+                fprintf( f, "%x %x %s\n", range->offset + (start << page_shift),
+                         min( (end - start) << page_shift, range->size - (start << page_shift) ), unix_name );
+                total++;
+            }
+            else end++;
+        }
+        free( vec );
+    }
+    free( unix_name );
+    return total;
+}
+
+
+/***********************************************************************
+ *           virtual_save_prefetch
+ *
+ * Stop recording and store the prefetch profile in the prefix.
+ */
+void virtual_save_prefetch(void)
+{
+    char *profile = InterlockedExchangePointer( (void **)&prefetch_profile, NULL );
+    unsigned int i, count, total = 0;
+    char *tmp, *p;
+    sigset_t sigset;
+    FILE *f;
+
+    if (!profile) return;
+
+    /* make sure no other thread is still adding images */
+    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    count = prefetch_count;
+    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+
+    if (!(tmp = malloc( strlen(profile) + 10 ))) goto done;
+    sprintf( tmp, "%s.%x", profile, getpid() );
+    p = strrchr( profile, '/' );
+    *p = 0;
+    mkdir( profile, 0777 );
+    *p = '/';
+
+    if ((f = fopen( tmp, "w" )))
+    {
+        for (i = 0; i < count; i++) total += write_prefetch_image( f, prefetch_images[i] );
+        if (!fclose( f ) && total && !rename( tmp, profile ))
+            TRACE( "%s: %u images, %u ranges, last image mapped after %u ms\n", debugstr_a(profile), count, total,
+                   (unsigned int)((prefetch_last_time - prefetch_start_time) / (TICKSPERSEC / 1000)) );
+        else
+            unlink( tmp );
+    }
+    free( tmp );
+
+done:
+    for (i = 0; i < count; i++)
+    {
+        free( prefetch_images[i]->name );
+        free( prefetch_images[i] );
+    }
+    free( prefetch_images );
+    free( profile );
+}
+
+
 /***********************************************************************
  *             virtual_map_image
  *
  * Map a PE image section into memory.
  */
 static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size_ptr, HANDLE shared_file,
-                                   ULONG_PTR limit_low, ULONG_PTR limit_high, ULONG alloc_type,
+                                   HANDLE relocated_file, ULONG_PTR limit_low, ULONG_PTR limit_high, ULONG alloc_type,
                                    USHORT machine, pe_image_info_t *image_info,
                                    WCHAR *filename, BOOL is_builtin )
 {
     int unix_fd = -1, needs_close;
     int shared_fd = -1, shared_needs_close = 0;
+    int reloc_fd = -1, reloc_needs_close = 0;
     SIZE_T size = image_info->map_size;
     struct file_view *view;
     unsigned int status;
+    BOOL prefetch_done = FALSE;
     sigset_t sigset;
 
     if ((status = server_get_unix_fd( mapping, 0, &unix_fd, &needs_close, NULL, NULL )))
@@ -3062,6 +3650,9 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
         return status;
     }
 
+    if (relocated_file)
+        server_get_unix_fd( relocated_file, FILE_READ_DATA, &reloc_fd, &reloc_needs_close, NULL, NULL );
+
     if (!image_info->map_addr &&
         (image_info->image_charact & IMAGE_FILE_DLL) &&
         (image_info->image_flags & IMAGE_FLAGS_ImageDynamicallyRelocated))
@@ -3069,9 +3660,19 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
         SERVER_START_REQ( get_image_map_address )
         {
             req->handle = wine_server_obj_handle( mapping );
-            if (!wine_server_call( req )) image_info->map_addr = reply->addr;
+            if (!wine_server_call( req ))
+            {
+                image_info->map_addr = reply->addr;
+                relocated_file = wine_server_ptr_handle( reply->relocated_file );
+            }
         }
         SERVER_END_REQ;
+        if (relocated_file)
+        {
+            if (reloc_fd == -1)
+                server_get_unix_fd( relocated_file, FILE_READ_DATA, &reloc_fd, &reloc_needs_close, NULL, NULL );
+            NtClose( relocated_file );
+        }
     }
 
     server_enter_uninterrupted_section( &virtual_mutex, &sigset );
@@ -3079,7 +3680,15 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
     status = map_image_view( &view, image_info, size, limit_low, limit_high, alloc_type );
     if (status) goto done;
 
-    status = map_image_into_view( view, filename, unix_fd, image_info, machine, shared_fd, needs_close );
+    /* the relocated copy is only usable if we got the address it was relocated to */
+    if (reloc_fd != -1 && view->base != wine_server_get_ptr( image_info->map_addr ))
+    {
+        if (reloc_needs_close) close( reloc_fd );
+        reloc_fd = -1;
+        reloc_needs_close = 0;
+    }
+
+    status = map_image_into_view( view, filename, unix_fd, image_info, machine, shared_fd, reloc_fd, needs_close );
     if (status == STATUS_SUCCESS)
     {
         SERVER_START_REQ( map_image_view )
@@ -3096,6 +3705,7 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
     if (NT_SUCCESS(status))
     {
         if (is_builtin) add_builtin_module( view->base, NULL );
+        prefetch_done = !record_prefetch_image( view, filename, image_info, reloc_fd != -1 );
         *addr_ptr = view->base;
         *size_ptr = size;
         VIRTUAL_DEBUG_DUMP_VIEW( view );
@@ -3106,6 +3716,8 @@ done:
     server_leave_uninterrupted_section( &virtual_mutex, &sigset );
     if (needs_close) close( unix_fd );
     if (shared_needs_close) close( shared_fd );
+    if (reloc_needs_close) close( reloc_fd );
+    if (prefetch_done) virtual_save_prefetch();
     return status;
 }
 
@@ -3130,7 +3742,7 @@ static unsigned int virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG_P
     int unix_handle = -1, needs_close;
     unsigned int vprot, sec_flags;
     struct file_view *view;
-    HANDLE shared_file;
+    HANDLE shared_file, relocated_file;
     LARGE_INTEGER offset;
     sigset_t sigset;
 
@@ -3156,7 +3768,7 @@ static unsigned int virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG_P
         return STATUS_INVALID_PAGE_PROTECTION;
     }
 
-    res = get_mapping_info( handle, access, &sec_flags, &full_size, &shared_file, &image_info );
+    res = get_mapping_info( handle, access, &sec_flags, &full_size, &shared_file, &relocated_file, &image_info );
     if (res) return res;
 
     if (image_info)
@@ -3165,9 +3777,10 @@ static unsigned int virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG_P
         /* check if we can replace that mapping with the builtin */
         res = load_builtin( image_info, filename, machine, addr_ptr, size_ptr, limit_low, limit_high );
         if (res == STATUS_IMAGE_ALREADY_LOADED)
-            res = virtual_map_image( handle, addr_ptr, size_ptr, shared_file, limit_low, limit_high,
-                                     alloc_type, machine, image_info, filename, FALSE );
+            res = virtual_map_image( handle, addr_ptr, size_ptr, shared_file, relocated_file, limit_low,
+                                     limit_high, alloc_type, machine, image_info, filename, FALSE );
         if (shared_file) NtClose( shared_file );
+        if (relocated_file) NtClose( relocated_file );
         free( image_info );
         return res;
     }
@@ -3400,13 +4013,13 @@ NTSTATUS virtual_map_builtin_module( HANDLE mapping, void **module, SIZE_T *size
 {
     mem_size_t full_size;
     unsigned int sec_flags;
-    HANDLE shared_file;
+    HANDLE shared_file, relocated_file;
     pe_image_info_t *image_info = NULL;
     NTSTATUS status;
     WCHAR *filename;
 
     if ((status = get_mapping_info( mapping, SECTION_MAP_READ,
-                                    &sec_flags, &full_size, &shared_file, &image_info )))
+                                    &sec_flags, &full_size, &shared_file, &relocated_file, &image_info )))
         return status;
 
     if (!image_info) return STATUS_INVALID_PARAMETER;
@@ -3427,12 +4040,13 @@ NTSTATUS virtual_map_builtin_module( HANDLE mapping, void **module, SIZE_T *size
     }
     else
     {
-        status = virtual_map_image( mapping, module, size, shared_file, limit_low, limit_high, 0,
-                                    machine, image_info, filename, TRUE );
+        status = virtual_map_image( mapping, module, size, shared_file, relocated_file, limit_low,
+                                    limit_high, 0, machine, image_info, filename, TRUE );
         virtual_fill_image_information( image_info, info );
     }
 
     if (shared_file) NtClose( shared_file );
+    if (relocated_file) NtClose( relocated_file );
     free( image_info );
     return status;
 }
@@ -3447,12 +4061,12 @@ NTSTATUS virtual_map_module( HANDLE mapping, void **module, SIZE_T *size, SECTIO
     unsigned int status;
     mem_size_t full_size;
     unsigned int sec_flags;
-    HANDLE shared_file;
+    HANDLE shared_file, relocated_file;
     pe_image_info_t *image_info = NULL;
     WCHAR *filename;
 
     if ((status = get_mapping_info( mapping, SECTION_MAP_READ,
-                                    &sec_flags, &full_size, &shared_file, &image_info )))
+                                    &sec_flags, &full_size, &shared_file, &relocated_file, &image_info )))
         return status;
 
     if (!image_info) return STATUS_INVALID_PARAMETER;
@@ -3464,11 +4078,12 @@ NTSTATUS virtual_map_module( HANDLE mapping, void **module, SIZE_T *size, SECTIO
     /* check if we can replace that mapping with the builtin */
     status = load_builtin( image_info, filename, machine, module, size, limit_low, limit_high );
     if (status == STATUS_IMAGE_ALREADY_LOADED)
-        status = virtual_map_image( mapping, module, size, shared_file, limit_low, limit_high, 0,
-                                    machine, image_info, filename, FALSE );
+        status = virtual_map_image( mapping, module, size, shared_file, relocated_file, limit_low,
+                                    limit_high, 0, machine, image_info, filename, FALSE );
 
     virtual_fill_image_information( image_info, info );
     if (shared_file) NtClose( shared_file );
+    if (relocated_file) NtClose( relocated_file );
     free( image_info );
     return status;
 }
@@ -3696,7 +4311,7 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
     NTSTATUS status = STATUS_SUCCESS;
     SIZE_T block_size = signal_stack_mask + 1;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    server_enter_uninterrupted_section( &teb_mutex, &sigset );
     if (next_free_teb)
     {
         ptr = next_free_teb;
@@ -3712,7 +4327,7 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
             if ((status = NtAllocateVirtualMemory( NtCurrentProcess(), &ptr, user_space_wow_limit,
                                                    &total, MEM_RESERVE, PAGE_READWRITE )))
             {
-                server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+                server_leave_uninterrupted_section( &teb_mutex, &sigset );
                 return status;
             }
             teb_block = ptr;
@@ -3723,14 +4338,14 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
                                  MEM_COMMIT, PAGE_READWRITE );
     }
     *ret_teb = teb = init_teb( ptr, is_wow64() );
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    server_leave_uninterrupted_section( &teb_mutex, &sigset );
 
     if ((status = signal_alloc_thread( teb )))
     {
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        server_enter_uninterrupted_section( &teb_mutex, &sigset );
         *(void **)ptr = next_free_teb;
         next_free_teb = ptr;
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        server_leave_uninterrupted_section( &teb_mutex, &sigset );
     }
     return status;
 }
@@ -3764,13 +4379,13 @@ void virtual_free_teb( TEB *teb )
         NtFreeVirtualMemory( GetCurrentProcess(), &ptr, &size, MEM_RELEASE );
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    server_enter_uninterrupted_section( &teb_mutex, &sigset );
     list_remove( &thread_data->entry );
     ptr = teb;
     if (!is_win64) ptr = (char *)ptr - teb_offset;
     *(void **)ptr = next_free_teb;
     next_free_teb = ptr;
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    server_leave_uninterrupted_section( &teb_mutex, &sigset );
 }
 
 
@@ -3784,7 +4399,7 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
 
     if (index < TLS_MINIMUM_AVAILABLE)
     {
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        server_enter_uninterrupted_section( &teb_mutex, &sigset );
         LIST_FOR_EACH_ENTRY( thread_data, &teb_list, struct ntdll_thread_data, entry )
         {
             TEB *teb = CONTAINING_RECORD( thread_data, TEB, GdiTebBatch );
@@ -3795,14 +4410,14 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
 #endif
             teb->TlsSlots[index] = 0;
         }
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        server_leave_uninterrupted_section( &teb_mutex, &sigset );
     }
     else
     {
         index -= TLS_MINIMUM_AVAILABLE;
         if (index >= 8 * sizeof(peb->TlsExpansionBitmapBits)) return STATUS_INVALID_PARAMETER;
 
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        server_enter_uninterrupted_section( &teb_mutex, &sigset );
         LIST_FOR_EACH_ENTRY( thread_data, &teb_list, struct ntdll_thread_data, entry )
         {
             TEB *teb = CONTAINING_RECORD( thread_data, TEB, GdiTebBatch );
@@ -3817,7 +4432,7 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
 #endif
             if (teb->TlsExpansionSlots) teb->TlsExpansionSlots[index] = 0;
         }
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        server_leave_uninterrupted_section( &teb_mutex, &sigset );
     }
     return STATUS_SUCCESS;
 }
@@ -4497,6 +5112,16 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
     }
 
     if (type & MEM_RESERVE_PLACEHOLDER && (protect != PAGE_NOACCESS)) return STATUS_INVALID_PARAMETER;
+    if (type & MEM_LARGE_PAGES)
+    {
+        /* large pages are always committed at allocation time */
+        if ((type & (MEM_COMMIT | MEM_RESERVE)) != (MEM_COMMIT | MEM_RESERVE)) return STATUS_INVALID_PARAMETER;
+        if (type & (MEM_WRITE_WATCH | MEM_RESERVE_PLACEHOLDER | MEM_REPLACE_PLACEHOLDER))
+            return STATUS_INVALID_PARAMETER;
+        if (((UINT_PTR)base | size) & large_page_mask) return STATUS_INVALID_PARAMETER;
+        if (align && align - 1 < large_page_mask) return STATUS_INVALID_PARAMETER;
+        if (!align) align = large_page_mask + 1;
+    }
     if (!arm64ec_view && (attributes & MEM_EXTENDED_PARAMETER_EC_CODE)) return STATUS_INVALID_PARAMETER;
 
     /* Reserve the memory */
@@ -4518,6 +5143,10 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
                                     align ? align - 1 : granularity_mask );
 
             if (status == STATUS_SUCCESS) base = view->base;
+#ifdef MADV_HUGEPAGE
+            /* use transparent huge pages; hugetlbfs would need a preallocated pool */
+            if (status == STATUS_SUCCESS && (type & MEM_LARGE_PAGES)) madvise( base, size, MADV_HUGEPAGE );
+#endif
         }
     }
     else if (type & MEM_RESET)
@@ -4572,7 +5201,8 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
 NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG_PTR zero_bits,
                                          SIZE_T *size_ptr, ULONG type, ULONG protect )
 {
-    static const ULONG type_mask = MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET;
+    static const ULONG type_mask = MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH
+                                   | MEM_RESET | MEM_LARGE_PAGES;
     ULONG_PTR limit;
 
     TRACE("%p %p %08lx %x %08x\n", process, *ret, *size_ptr, (int)type, (int)protect );
@@ -4712,7 +5342,8 @@ NTSTATUS WINAPI NtAllocateVirtualMemoryEx( HANDLE process, PVOID *ret, SIZE_T *s
                                            ULONG count )
 {
     static const ULONG type_mask = MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH
-                                   | MEM_RESET | MEM_RESERVE_PLACEHOLDER | MEM_REPLACE_PLACEHOLDER;
+                                   | MEM_RESET | MEM_RESERVE_PLACEHOLDER | MEM_REPLACE_PLACEHOLDER
+                                   | MEM_LARGE_PAGES;
     ULONG_PTR limit_low = 0;
     ULONG_PTR limit_high = 0;
     ULONG_PTR align = 0;
@@ -5614,7 +6245,9 @@ static NTSTATUS unmap_view_of_section( HANDLE process, PVOID addr, ULONG flags )
     if (view->protect & VPROT_SYSTEM)
     {
         struct builtin_module *builtin;
+        BOOL in_use = FALSE;
 
+        mutex_lock( &builtin_mutex );
         LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
         {
             if (builtin->module != view->base) continue;
@@ -5622,9 +6255,15 @@ static NTSTATUS unmap_view_of_section( HANDLE process, PVOID addr, ULONG flags )
             {
                 TRACE( "not freeing in-use builtin %p\n", view->base );
                 builtin->refcount--;
-                server_leave_uninterrupted_section( &virtual_mutex, &sigset );
-                return STATUS_SUCCESS;
+                in_use = TRUE;
             }
+            break;
+        }
+        mutex_unlock( &builtin_mutex );
+        if (in_use)
+        {
+            server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+            return STATUS_SUCCESS;
         }
     }
 
@@ -5817,6 +6456,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
                                  ULONG_PTR *count, ULONG *granularity )
 {
     NTSTATUS status = STATUS_SUCCESS;
+    struct file_view *view;
     sigset_t sigset;
 
     size = ROUND_SIZE( base, size );
@@ -5833,18 +6473,26 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
 
     server_enter_uninterrupted_section( &virtual_mutex, &sigset );
 
-    if (is_write_watch_range( base, size ))
+    if ((view = find_view( base, size )) && (view->protect & VPROT_WRITEWATCH))
     {
         ULONG_PTR pos = 0;
         char *addr = base;
         char *end = addr + size;
 
-        while (pos < *count && addr < end)
+        if (view->protect & VPROT_KERNEL_WRITEWATCH)
+        {
+            pos = *count;
+            kernel_writewatch_scan( base, end, addresses, &pos, flags & WRITE_WATCH_FLAG_RESET );
+        }
+        else
         {
-            if (!(get_page_vprot( addr ) & VPROT_WRITEWATCH)) addresses[pos++] = addr;
-            addr += page_size;
+            while (pos < *count && addr < end)
+            {
+                if (!(get_page_vprot( addr ) & VPROT_WRITEWATCH)) addresses[pos++] = addr;
+                addr += page_size;
+            }
+            if (flags & WRITE_WATCH_FLAG_RESET) reset_write_watches( view, base, addr - (char *)base );
         }
-        if (flags & WRITE_WATCH_FLAG_RESET) reset_write_watches( base, addr - (char *)base );
         *count = pos;
         *granularity = page_size;
     }
@@ -5862,6 +6510,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
 NTSTATUS WINAPI NtResetWriteWatch( HANDLE process, PVOID base, SIZE_T size )
 {
     NTSTATUS status = STATUS_SUCCESS;
+    struct file_view *view;
     sigset_t sigset;
 
     size = ROUND_SIZE( base, size );
@@ -5873,8 +6522,8 @@ NTSTATUS WINAPI NtResetWriteWatch( HANDLE process, PVOID base, SIZE_T size )
 
     server_enter_uninterrupted_section( &virtual_mutex, &sigset );
 
-    if (is_write_watch_range( base, size ))
-        reset_write_watches( base, size );
+    if ((view = find_view( base, size )) && (view->protect & VPROT_WRITEWATCH))
+        reset_write_watches( view, base, size );
     else
         status = STATUS_INVALID_PARAMETER;
 
@@ -48,6 +48,8 @@ typedef struct FileLockBytesImpl
     HANDLE hfile;
     DWORD flProtect;
     LPWSTR pwcsName;
+    BYTE *view;
+    ULONGLONG view_size;
 } FileLockBytesImpl;
 
 static const ILockBytesVtbl FileLockBytesImpl_Vtbl;
@@ -78,6 +80,50 @@ static DWORD GetProtectMode(DWORD openFlags)
     return PAGE_READONLY;
 }
 
+/****************************************************************************
+ *      MapReadOnlyFile
+ *
+ * Read-only files that nobody else may write to are mapped into memory, so
+ * that sector reads don't need a seek and a read call each.
+ */
+static void MapReadOnlyFile(FileLockBytesImpl *This, DWORD openFlags)
+{
+    LARGE_INTEGER size;
+    HANDLE mapping;
+
+    This->view = NULL;
+    This->view_size = 0;
+
+    if (This->flProtect != PAGE_READONLY)
+        return;
+
+    switch (STGM_SHARE_MODE(openFlags))
+    {
+    case STGM_SHARE_DENY_WRITE:
+    case STGM_SHARE_EXCLUSIVE:
+        break;
+    default:
+        return;
+    }
+
+    if (!GetFileSizeEx(This->hfile, &size) || !size.QuadPart || size.QuadPart > (SIZE_T)~0)
+        return;
+
+    if (!(mapping = CreateFileMappingW(This->hfile, NULL, PAGE_READONLY, 0, 0, NULL)))
+    {
+        WARN("failed to create mapping, error %lu\n", GetLastError());
+        return;
+    }
+
+    This->view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+
+    if (This->view)
+        This->view_size = size.QuadPart;
+    else
+        WARN("failed to map view, error %lu\n", GetLastError());
+}
+
 /******************************************************************************
  *      FileLockBytesImpl_Construct
  *
@@ -100,6 +146,7 @@ HRESULT FileLockBytesImpl_Construct(HANDLE hFile, DWORD openFlags, LPCWSTR pwcsN
   This->ref = 1;
   This->hfile = hFile;
   This->flProtect = GetProtectMode(openFlags);
+  MapReadOnlyFile(This, openFlags);
 
   if(pwcsName) {
     if (!GetFullPathNameW(pwcsName, MAX_PATH, fullpath, NULL))
@@ -110,6 +157,7 @@ HRESULT FileLockBytesImpl_Construct(HANDLE hFile, DWORD openFlags, LPCWSTR pwcsN
                               (lstrlenW(fullpath)+1)*sizeof(WCHAR));
     if (!This->pwcsName)
     {
+       if (This->view) UnmapViewOfFile(This->view);
        HeapFree(GetProcessHeap(), 0, This);
        return E_OUTOFMEMORY;
     }
@@ -156,6 +204,7 @@ static ULONG WINAPI FileLockBytesImpl_Release(ILockBytes *iface)
 
     if (ref == 0)
     {
+        if (This->view) UnmapViewOfFile(This->view);
         CloseHandle(This->hfile);
         HeapFree(GetProcessHeap(), 0, This->pwcsName);
         HeapFree(GetProcessHeap(), 0, This);
@@ -194,6 +243,22 @@ static HRESULT WINAPI FileLockBytesImpl_ReadAt(
     if (pcbRead)
         *pcbRead = 0;
 
+    if (This->view)
+    {
+        if (ulOffset.QuadPart >= This->view_size)
+            return cb ? STG_E_READFAULT : S_OK;
+
+        if (bytes_left > This->view_size - ulOffset.QuadPart)
+            bytes_left = This->view_size - ulOffset.QuadPart;
+
+        memcpy(readPtr, This->view + ulOffset.QuadPart, bytes_left);
+
+        if (pcbRead)
+            *pcbRead = bytes_left;
+
+        return bytes_left == cb ? S_OK : STG_E_READFAULT;
+    }
+
     offset.QuadPart = ulOffset.QuadPart;
 
     ret = SetFilePointerEx(This->hfile, offset, NULL, FILE_BEGIN);
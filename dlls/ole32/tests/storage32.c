@@ -2293,6 +2293,94 @@ static void test_readonly(void)
     DeleteFileA("winetest");
 }
 
+static BYTE stream_pattern(ULONG pos)
+{
+    return (pos * 7) ^ (pos >> 9);
+}
+
+static void test_readonly_random_access(void)
+{
+    static const ULONG offsets[] = { 0, 511, 4096, 70000, 123457, 199990, 64, 150000, 3 };
+    IStorage *stg, *stg2;
+    IStream *stream, *stream2;
+    LARGE_INTEGER pos;
+    BYTE *buffer, small[100];
+    ULONG size = 200000, i, count;
+    HRESULT hr;
+
+    buffer = malloc(size);
+    for (i = 0; i < size; i++) buffer[i] = stream_pattern(i);
+
+    hr = StgCreateDocfile(filename, STGM_CREATE | STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, &stg);
+    ok(hr == S_OK, "StgCreateDocfile failed, hr %#lx.\n", hr);
+
+    hr = IStorage_CreateStream(stg, strmB_name, STGM_CREATE | STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, 0, &stream);
+    ok(hr == S_OK, "CreateStream failed, hr %#lx.\n", hr);
+    hr = IStream_Write(stream, buffer, size, &count);
+    ok(hr == S_OK, "Write failed, hr %#lx.\n", hr);
+    ok(count == size, "got %lu\n", count);
+    IStream_Release(stream);
+
+    hr = IStorage_CreateStream(stg, strmA_name, STGM_CREATE | STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, 0, &stream);
+    ok(hr == S_OK, "CreateStream failed, hr %#lx.\n", hr);
+    hr = IStream_Write(stream, buffer + 1000, sizeof(small), &count);
+    ok(hr == S_OK, "Write failed, hr %#lx.\n", hr);
+    IStream_Release(stream);
+
+    IStorage_Release(stg);
+
+    /* read-only storages may be served from a file mapping */
+    hr = StgOpenStorage(filename, NULL, STGM_READ | STGM_SHARE_DENY_WRITE, NULL, 0, &stg);
+    ok(hr == S_OK, "StgOpenStorage failed, hr %#lx.\n", hr);
+    hr = StgOpenStorage(filename, NULL, STGM_READ | STGM_SHARE_DENY_WRITE, NULL, 0, &stg2);
+    ok(hr == S_OK, "StgOpenStorage failed, hr %#lx.\n", hr);
+
+    hr = IStorage_OpenStream(stg, strmB_name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &stream);
+    ok(hr == S_OK, "OpenStream failed, hr %#lx.\n", hr);
+    hr = IStorage_OpenStream(stg2, strmB_name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &stream2);
+    ok(hr == S_OK, "OpenStream failed, hr %#lx.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(offsets); i++)
+    {
+        BYTE data[1000];
+        ULONG len = min(sizeof(data), size - offsets[i]);
+
+        pos.QuadPart = offsets[i];
+        hr = IStream_Seek(i % 2 ? stream : stream2, pos, STREAM_SEEK_SET, NULL);
+        ok(hr == S_OK, "Seek failed, hr %#lx.\n", hr);
+        memset(data, 0xcc, sizeof(data));
+        hr = IStream_Read(i % 2 ? stream : stream2, data, sizeof(data), &count);
+        ok(hr == S_OK, "Read failed, hr %#lx.\n", hr);
+        ok(count == len, "%lu: got %lu\n", i, count);
+        ok(!memcmp(data, buffer + offsets[i], len), "%lu: wrong data\n", i);
+    }
+
+    pos.QuadPart = size - 10;
+    hr = IStream_Seek(stream, pos, STREAM_SEEK_SET, NULL);
+    ok(hr == S_OK, "Seek failed, hr %#lx.\n", hr);
+    hr = IStream_Read(stream, small, sizeof(small), &count);
+    ok(hr == S_OK, "Read failed, hr %#lx.\n", hr);
+    ok(count == 10, "got %lu\n", count);
+
+    IStream_Release(stream2);
+    IStream_Release(stream);
+
+    hr = IStorage_OpenStream(stg, strmA_name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &stream);
+    ok(hr == S_OK, "OpenStream failed, hr %#lx.\n", hr);
+    memset(small, 0, sizeof(small));
+    hr = IStream_Read(stream, small, sizeof(small), &count);
+    ok(hr == S_OK, "Read failed, hr %#lx.\n", hr);
+    ok(count == sizeof(small), "got %lu\n", count);
+    ok(!memcmp(small, buffer + 1000, sizeof(small)), "wrong data\n");
+    IStream_Release(stream);
+
+    IStorage_Release(stg2);
+    IStorage_Release(stg);
+
+    free(buffer);
+    DeleteFileA(filenameA);
+}
+
 static void test_simple(void)
 {
     /* Tests for STGM_SIMPLE mode */
@@ -3951,6 +4039,7 @@ START_TEST(storage32)
     test_access();
     test_writeclassstg();
     test_readonly();
+    test_readonly_random_access();
     test_simple();
     test_fmtusertypestg();
     test_references();
@@ -8572,6 +8572,59 @@ static void test_DeleteFuncDesc(void)
     DeleteFileW(filenameW);
 }
 
+static void test_lazy_members(const WCHAR *filename)
+{
+    static const IID iid_itestiface = {0xec5dfcd6,0xeeb0,0x4cd6,{0xb5,0x1e,0x80,0x30,0xe1,0xda,0xc0,0x0a}};
+    static const WCHAR *func_names[] = { L"test1", L"test2", L"test3", L"test4", L"test5", L"test6" };
+    BSTR names[2];
+    ITypeInfo *ti;
+    ITypeLib *tl;
+    TYPEATTR *attr;
+    FUNCDESC *desc;
+    UINT i, count;
+    HRESULT hr;
+
+    hr = LoadTypeLibEx(filename, REGKIND_NONE, &tl);
+    ok(hr == S_OK, "got %#lx\n", hr);
+    if (FAILED(hr)) return;
+
+    hr = ITypeLib_GetTypeInfoOfGuid(tl, &iid_itestiface, &ti);
+    ok(hr == S_OK, "got %#lx\n", hr);
+    /* the members are only read when first needed, the typeinfo keeps the library alive */
+    ITypeLib_Release(tl);
+    if (FAILED(hr)) return;
+
+    hr = ITypeInfo_GetTypeAttr(ti, &attr);
+    ok(hr == S_OK, "got %#lx\n", hr);
+    ok(attr->cFuncs == ARRAY_SIZE(func_names), "got %u functions\n", attr->cFuncs);
+    ITypeInfo_ReleaseTypeAttr(ti, attr);
+
+    for (i = 0; i < ARRAY_SIZE(func_names); i++)
+    {
+        hr = ITypeInfo_GetFuncDesc(ti, i, &desc);
+        ok(hr == S_OK, "%u: got %#lx\n", i, hr);
+        if (FAILED(hr)) continue;
+        ok(desc->memid == 0x60020000 + i, "%u: got memid %#lx\n", i, desc->memid);
+        ok(desc->cParams == 1, "%u: got %d params\n", i, desc->cParams);
+        ok(desc->oVft == (7 + i) * sizeof(void *), "%u: got vtable offset %d\n", i, desc->oVft);
+
+        count = 0;
+        hr = ITypeInfo_GetNames(ti, desc->memid, names, ARRAY_SIZE(names), &count);
+        ok(hr == S_OK, "%u: got %#lx\n", i, hr);
+        ok(count == 2, "%u: got %u names\n", i, count);
+        if (count == 2)
+        {
+            ok(!lstrcmpW(names[0], func_names[i]), "%u: got %s\n", i, wine_dbgstr_w(names[0]));
+            ok(!lstrcmpW(names[1], L"value"), "%u: got %s\n", i, wine_dbgstr_w(names[1]));
+            SysFreeString(names[0]);
+            SysFreeString(names[1]);
+        }
+        ITypeInfo_ReleaseFuncDesc(ti, desc);
+    }
+
+    ITypeInfo_Release(ti);
+}
+
 START_TEST(typelib)
 {
     const WCHAR *filename;
@@ -8601,6 +8654,7 @@ START_TEST(typelib)
     if ((filename = create_test_typelib(2)))
     {
         test_dump_typelib( filename );
+        test_lazy_members( filename );
         DeleteFileW( filename );
     }
 
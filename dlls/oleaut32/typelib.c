@@ -1106,6 +1106,12 @@ typedef struct tagITypeLibImpl
     struct list entry;
     WCHAR *path;
     INT index;
+
+    /* MSFT image that typeinfo members are read from on first use */
+    IUnknown *image;
+    void *image_base;
+    DWORD image_length;
+    MSFT_SegDir image_segdir;
 } ITypeLibImpl;
 
 static const ITypeLib2Vtbl tlbvt;
@@ -1133,7 +1139,7 @@ static inline ITypeLibImpl *impl_from_ICreateTypeLib2( ICreateTypeLib2 *iface )
 }
 
 /* ITypeLib methods */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength);
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *pFile);
 static ITypeLib2* ITypeLib2_Constructor_SLTG(LPVOID pLib, DWORD dwTLBLength);
 
 /*======================= ITypeInfo implementation =======================*/
@@ -1180,6 +1186,7 @@ typedef struct tagTLBFuncDesc
     const TLBString *HelpString;
     const TLBString *Entry;            /* if IS_INTRESOURCE true, it's numeric; if -1 it isn't present */
     struct list custdata_list;
+    VARTYPE *param_vts;     /* variant types of the params, cached by Invoke */
 } TLBFuncDesc;
 
 /* internal Variable data */
@@ -1202,6 +1209,19 @@ typedef struct tagTLBImplType
     struct list custdata_list;
 } TLBImplType;
 
+/* name and memid lookup tables for GetIDsOfNames and Invoke, built on first use */
+typedef struct tagTLBMemberIndex
+{
+    UINT name_mask;         /* size of the names hash table - 1 */
+    int *names;             /* 0 if free, func index + 1 or -(var index + 1); NULL if not usable */
+    UINT memid_count;
+    struct tlb_memid_func
+    {
+        MEMBERID memid;
+        UINT index;
+    } *memids;              /* funcs sorted by memid, then by index */
+} TLBMemberIndex;
+
 /* internal TypeInfo data */
 typedef struct tagITypeInfoImpl
 {
@@ -1240,18 +1260,36 @@ typedef struct tagITypeInfoImpl
 
     struct list *pcustdata_list;
     struct list custdata_list;
+
+    TLBMemberIndex *member_index;
+
+    /* funcs and vars of typeinfos loaded from MSFT images are read on first use */
+    LONG members_pending;
+    int members_offset;
 } ITypeInfoImpl;
 
+static void TLB_load_members(ITypeInfoImpl *info);
+
 static inline ITypeInfoImpl *info_impl_from_ITypeComp( ITypeComp *iface )
 {
-    return CONTAINING_RECORD(iface, ITypeInfoImpl, ITypeComp_iface);
+    ITypeInfoImpl *info = CONTAINING_RECORD(iface, ITypeInfoImpl, ITypeComp_iface);
+    TLB_load_members(info);
+    return info;
 }
 
-static inline ITypeInfoImpl *impl_from_ITypeInfo2( ITypeInfo2 *iface )
+/* for methods that don't need the funcs and vars */
+static inline ITypeInfoImpl *impl_from_ITypeInfo2_noload( ITypeInfo2 *iface )
 {
     return CONTAINING_RECORD(iface, ITypeInfoImpl, ITypeInfo2_iface);
 }
 
+static inline ITypeInfoImpl *impl_from_ITypeInfo2( ITypeInfo2 *iface )
+{
+    ITypeInfoImpl *info = impl_from_ITypeInfo2_noload(iface);
+    TLB_load_members(info);
+    return info;
+}
+
 static inline ITypeInfoImpl *impl_from_ITypeInfo( ITypeInfo *iface )
 {
     return impl_from_ITypeInfo2((ITypeInfo2*)iface);
@@ -1259,7 +1297,9 @@ static inline ITypeInfoImpl *impl_from_ITypeInfo( ITypeInfo *iface )
 
 static inline ITypeInfoImpl *info_impl_from_ICreateTypeInfo2( ICreateTypeInfo2 *iface )
 {
-    return CONTAINING_RECORD(iface, ITypeInfoImpl, ICreateTypeInfo2_iface);
+    ITypeInfoImpl *info = CONTAINING_RECORD(iface, ITypeInfoImpl, ICreateTypeInfo2_iface);
+    TLB_load_members(info);
+    return info;
 }
 
 static const ITypeInfo2Vtbl tinfvt;
@@ -1705,6 +1745,148 @@ static inline TLBVarDesc *TLB_get_vardesc_by_name(ITypeInfoImpl *typeinfo, const
     return NULL;
 }
 
+/* Hashes a member name consistently with lstrcmpiW(). Fails for names that
+ * contain anything else than ASCII letters, digits and underscores, since
+ * those may compare equal in other ways than by case folding. */
+static BOOL TLB_hash_name(const WCHAR *name, UINT *hash)
+{
+    UINT ret = 0;
+
+    if (!name) return FALSE;
+    for (; *name; name++)
+    {
+        WCHAR c = *name;
+
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        else if (!(c >= 'a' && c <= 'z') && !(c >= '0' && c <= '9') && c != '_') return FALSE;
+        ret = ret * 31 + c;
+    }
+    *hash = ret;
+    return TRUE;
+}
+
+static const TLBString *TLB_get_index_name(const ITypeInfoImpl *typeinfo, int entry)
+{
+    if (entry > 0) return typeinfo->funcdescs[entry - 1].Name;
+    return typeinfo->vardescs[-entry - 1].Name;
+}
+
+static BOOL TLB_index_add_name(const ITypeInfoImpl *typeinfo, TLBMemberIndex *index, const TLBString *name, int entry)
+{
+    UINT hash, i;
+
+    /* unnamed members can't be looked up by name anyway */
+    if (!name) return TRUE;
+    if (!TLB_hash_name(name->str, &hash)) return FALSE;
+
+    for (i = hash & index->name_mask; index->names[i]; i = (i + 1) & index->name_mask)
+    {
+        /* keep the first member with a given name, like a linear search would */
+        if (!lstrcmpiW(TLB_get_bstr(TLB_get_index_name(typeinfo, index->names[i])), name->str))
+            return TRUE;
+    }
+    index->names[i] = entry;
+    return TRUE;
+}
+
+static int __cdecl TLB_memid_func_cmp(const void *a, const void *b)
+{
+    const struct tlb_memid_func *left = a, *right = b;
+
+    if (left->memid != right->memid) return left->memid < right->memid ? -1 : 1;
+    if (left->index != right->index) return left->index < right->index ? -1 : 1;
+    return 0;
+}
+
+static void TLB_free_member_index(ITypeInfoImpl *typeinfo)
+{
+    UINT i;
+
+    free(typeinfo->member_index);
+    typeinfo->member_index = NULL;
+    for (i = 0; i < typeinfo->typeattr.cFuncs; ++i)
+    {
+        free(typeinfo->funcdescs[i].param_vts);
+        typeinfo->funcdescs[i].param_vts = NULL;
+    }
+}
+
+static TLBMemberIndex *TLB_get_member_index(ITypeInfoImpl *typeinfo)
+{
+    UINT i, size, funcs = typeinfo->typeattr.cFuncs, vars = typeinfo->typeattr.cVars;
+    TLBMemberIndex *index;
+
+    if ((index = typeinfo->member_index)) return index;
+    /* members may still change while the typeinfo is being created */
+    if (typeinfo->needs_layout) return NULL;
+
+    for (size = 16; size < (funcs + vars) * 2; size <<= 1)
+        ;
+    if (!(index = malloc(sizeof(*index) + size * sizeof(*index->names) + funcs * sizeof(*index->memids))))
+        return NULL;
+
+    index->name_mask = size - 1;
+    index->names = (int *)(index + 1);
+    memset(index->names, 0, size * sizeof(*index->names));
+    index->memid_count = funcs;
+    index->memids = (struct tlb_memid_func *)(index->names + size);
+
+    for (i = 0; i < funcs; ++i)
+    {
+        index->memids[i].memid = typeinfo->funcdescs[i].funcdesc.memid;
+        index->memids[i].index = i;
+        if (index->names && !TLB_index_add_name(typeinfo, index, typeinfo->funcdescs[i].Name, i + 1))
+            index->names = NULL;
+    }
+    for (i = 0; i < vars && index->names; ++i)
+    {
+        if (!TLB_index_add_name(typeinfo, index, typeinfo->vardescs[i].Name, -(int)i - 1))
+            index->names = NULL;
+    }
+    qsort(index->memids, funcs, sizeof(*index->memids), TLB_memid_func_cmp);
+
+    if (InterlockedCompareExchangePointer((void **)&typeinfo->member_index, index, NULL))
+    {
+        free(index);
+        index = typeinfo->member_index;
+    }
+    return index;
+}
+
+/* Finds a function, or failing that a variable, by name. */
+static void TLB_get_member_by_name(ITypeInfoImpl *typeinfo, const OLECHAR *name,
+        const TLBFuncDesc **func, const TLBVarDesc **var)
+{
+    TLBMemberIndex *index = TLB_get_member_index(typeinfo);
+    UINT hash, i;
+    int entry;
+
+    *func = NULL;
+    *var = NULL;
+
+    if (index && index->names && TLB_hash_name(name, &hash))
+    {
+        for (i = hash & index->name_mask; (entry = index->names[i]); i = (i + 1) & index->name_mask)
+        {
+            if (lstrcmpiW(name, TLB_get_bstr(TLB_get_index_name(typeinfo, entry)))) continue;
+            if (entry > 0) *func = &typeinfo->funcdescs[entry - 1];
+            else *var = &typeinfo->vardescs[-entry - 1];
+            break;
+        }
+        return;
+    }
+
+    for (i = 0; i < typeinfo->typeattr.cFuncs; ++i)
+    {
+        if (!lstrcmpiW(name, TLB_get_bstr(typeinfo->funcdescs[i].Name)))
+        {
+            *func = &typeinfo->funcdescs[i];
+            return;
+        }
+    }
+    *var = TLB_get_vardesc_by_name(typeinfo, name);
+}
+
 static inline TLBCustData *TLB_get_custdata_by_guid(const struct list *custdata_list, REFGUID guid)
 {
     TLBCustData *cust_data;
@@ -2708,16 +2890,9 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
 /* note: InfoType's Help file and HelpStringDll come from the containing
  * library. Further HelpString and Docstring appear to be the same thing :(
  */
-    /* functions */
-    if(ptiRet->typeattr.cFuncs >0 )
-        MSFT_DoFuncs(pcx, ptiRet, ptiRet->typeattr.cFuncs,
-		    ptiRet->typeattr.cVars,
-		    tiBase.memoffset, &ptiRet->funcdescs);
-    /* variables */
-    if(ptiRet->typeattr.cVars >0 )
-        MSFT_DoVars(pcx, ptiRet, ptiRet->typeattr.cFuncs,
-		   ptiRet->typeattr.cVars,
-		   tiBase.memoffset, &ptiRet->vardescs);
+    /* functions and variables are read by TLB_load_members() when needed */
+    ptiRet->members_offset = tiBase.memoffset;
+    ptiRet->members_pending = ptiRet->typeattr.cFuncs > 0 || ptiRet->typeattr.cVars > 0;
     if(ptiRet->typeattr.cImplTypes >0 ) {
         switch(ptiRet->typeattr.typekind)
         {
@@ -2751,11 +2926,56 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
        debugstr_guid(TLB_get_guidref(ptiRet->guid)),
        typekind_desc[ptiRet->typeattr.typekind]);
     if (TRACE_ON(typelib))
+    {
+      TLB_load_members(ptiRet);
       dump_TypeInfo(ptiRet);
+    }
 
     return ptiRet;
 }
 
+static CRITICAL_SECTION members_section;
+static CRITICAL_SECTION_DEBUG members_section_debug =
+{
+    0, 0, &members_section,
+    { &members_section_debug.ProcessLocksList, &members_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": typeinfo members") }
+};
+static CRITICAL_SECTION members_section = { &members_section_debug, -1, 0, 0, 0, 0 };
+
+/* Reads the funcs and vars of a typeinfo from the typelib image. Most
+ * applications only look at a few of the typeinfos of large typelibs, so this
+ * is deferred until the members are first needed. */
+static void TLB_load_members(ITypeInfoImpl *info)
+{
+    ITypeLibImpl *lib = info->pTypeLib;
+    TLBContext cx;
+
+    if (!ReadAcquire(&info->members_pending)) return;
+
+    EnterCriticalSection(&members_section);
+    if (info->members_pending)
+    {
+        TRACE_(typelib)("reading members of %s\n", debugstr_w(TLB_get_bstr(info->Name)));
+
+        cx.oStart = 0;
+        cx.pos = 0;
+        cx.length = lib->image_length;
+        cx.mapping = lib->image_base;
+        cx.pTblDir = &lib->image_segdir;
+        cx.pLibInfo = lib;
+
+        if (info->typeattr.cFuncs > 0)
+            MSFT_DoFuncs(&cx, info, info->typeattr.cFuncs, info->typeattr.cVars,
+                         info->members_offset, &info->funcdescs);
+        if (info->typeattr.cVars > 0)
+            MSFT_DoVars(&cx, info, info->typeattr.cFuncs, info->typeattr.cVars,
+                        info->members_offset, &info->vardescs);
+        InterlockedExchange(&info->members_pending, FALSE);
+    }
+    LeaveCriticalSection(&members_section);
+}
+
 static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
 {
     char *string;
@@ -3238,6 +3458,7 @@ static const IUnknownVtbl TLB_Mapping_Vtable =
 static HRESULT TLB_Mapping_Open(LPCWSTR path, LPVOID *ppBase, DWORD *pdwTLBLength, IUnknown **ppFile)
 {
     TLB_Mapping *This;
+    DWORD size;
 
     This = malloc(sizeof(TLB_Mapping));
     if (!This)
@@ -3252,14 +3473,19 @@ static HRESULT TLB_Mapping_Open(LPCWSTR path, LPVOID *ppBase, DWORD *pdwTLBLengt
     This->file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0);
     if (INVALID_HANDLE_VALUE != This->file)
     {
+        /* retrieve file size */
+        size = GetFileSize(This->file, NULL);
         This->mapping = CreateFileMappingW(This->file, NULL, PAGE_READONLY | SEC_COMMIT, 0, 0, NULL);
+        /* members are read from the mapping on first use, which may be much later;
+         * don't keep the file open and locked against writing for that long */
+        CloseHandle(This->file);
+        This->file = INVALID_HANDLE_VALUE;
         if (This->mapping)
         {
             This->typelib_base = MapViewOfFile(This->mapping, FILE_MAP_READ, 0, 0, 0);
             if(This->typelib_base)
             {
-                /* retrieve file size */
-                *pdwTLBLength = GetFileSize(This->file, NULL);
+                *pdwTLBLength = size;
                 *ppBase = This->typelib_base;
                 *ppFile = &This->IUnknown_iface;
                 return S_OK;
@@ -3359,7 +3585,7 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
         {
             DWORD dwSignature = FromLEDWord(*((DWORD*) pBase));
             if (dwSignature == MSFT_SIGNATURE)
-                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength);
+                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength, pFile);
             else if (dwSignature == SLTG_SIGNATURE)
                 *ppTypeLib = ITypeLib2_Constructor_SLTG(pBase, dwTLBLength);
             else
@@ -3429,7 +3655,7 @@ static ITypeLibImpl* TypeLibImpl_Constructor(void)
  *
  * loading an MSFT typelib from an in-memory image
  */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *pFile)
 {
     TLBContext cx;
     LONG lPSegDir;
@@ -3478,6 +3704,13 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
 	return NULL;
     }
 
+    /* keep the image around for TLB_load_members() */
+    pTypeLibImpl->image = pFile;
+    IUnknown_AddRef(pFile);
+    pTypeLibImpl->image_base = pLib;
+    pTypeLibImpl->image_length = dwTLBLength;
+    pTypeLibImpl->image_segdir = tlbSegDir;
+
     MSFT_ReadAllNames(&cx);
     MSFT_ReadAllStrings(&cx);
     MSFT_ReadAllGuids(&cx);
@@ -4780,6 +5013,8 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
           ITypeInfoImpl_Destroy(This->typeinfos[i]);
       }
       free(This->typeinfos);
+      if (This->image)
+          IUnknown_Release(This->image);
       free(This);
     }
 
@@ -5034,6 +5269,7 @@ static HRESULT WINAPI ITypeLib2_fnIsName(
     for(tic = 0; tic < This->TypeInfoCount; ++tic){
         ITypeInfoImpl *pTInfo = This->typeinfos[tic];
         if(!TLB_str_memcmp(szNameBuf, pTInfo->Name, nNameBufLen)) goto ITypeLib2_fnIsName_exit;
+        TLB_load_members(pTInfo);
         for(fdc = 0; fdc < pTInfo->typeattr.cFuncs; ++fdc) {
             TLBFuncDesc *pFInfo = &pTInfo->funcdescs[fdc];
             int pc;
@@ -5093,6 +5329,7 @@ static HRESULT WINAPI ITypeLib2_fnFindName(
             goto ITypeLib2_fnFindName_exit;
         }
 
+        TLB_load_members(pTInfo);
         for(fdc = 0; fdc < pTInfo->typeattr.cFuncs; ++fdc) {
             TLBFuncDesc *func = &pTInfo->funcdescs[fdc];
 
@@ -5540,7 +5777,7 @@ static HRESULT WINAPI ITypeInfo_fnQueryInterface(
 	REFIID riid,
 	VOID **ppvObject)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
 
     TRACE("(%p)->(IID: %s)\n",This,debugstr_guid(riid));
 
@@ -5566,7 +5803,7 @@ static HRESULT WINAPI ITypeInfo_fnQueryInterface(
 
 static ULONG WINAPI ITypeInfo_fnAddRef( ITypeInfo2 *iface)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
     ULONG ref = InterlockedIncrement(&This->ref);
 
     TRACE("%p, refcount %lu.\n", iface, ref);
@@ -5590,6 +5827,7 @@ static void typeinfo_release_funcdesc(TLBFuncDesc *func)
     }
     free(func->funcdesc.lprgelemdescParam);
     free(func->pParamDesc);
+    free(func->param_vts);
     TLB_FreeCustData(&func->custdata_list);
 }
 
@@ -5599,6 +5837,12 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TRACE("destroying ITypeInfo(%p)\n",This);
 
+    free(This->member_index);
+
+    /* nothing to free if the members were never read */
+    if (This->members_pending)
+        This->typeattr.cFuncs = This->typeattr.cVars = 0;
+
     for (i = 0; i < This->typeattr.cFuncs; ++i)
     {
         typeinfo_release_funcdesc(&This->funcdescs[i]);
@@ -5633,7 +5877,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
 static ULONG WINAPI ITypeInfo_fnRelease(ITypeInfo2 *iface)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
     ULONG ref = InterlockedDecrement(&This->ref);
 
     TRACE("%p, refcount %lu.\n", iface, ref);
@@ -5643,7 +5887,10 @@ static ULONG WINAPI ITypeInfo_fnRelease(ITypeInfo2 *iface)
         BOOL not_attached_to_typelib = This->not_attached_to_typelib;
         ITypeLib2_Release(&This->pTypeLib->ITypeLib2_iface);
         if (not_attached_to_typelib)
+        {
+            free(This->member_index);
             free(This);
+        }
         /* otherwise This will be freed when typelib is freed */
     }
 
@@ -5653,7 +5900,7 @@ static ULONG WINAPI ITypeInfo_fnRelease(ITypeInfo2 *iface)
 static HRESULT WINAPI ITypeInfo_fnGetTypeAttr( ITypeInfo2 *iface,
         LPTYPEATTR  *ppTypeAttr)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
     SIZE_T size;
 
     TRACE("(%p)\n",This);
@@ -6173,7 +6420,7 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeOfImplType(
         UINT index,
 	HREFTYPE  *pRefType)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
     HRESULT hr = S_OK;
 
     TRACE("(%p) index %d\n", This, index);
@@ -6229,7 +6476,7 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeOfImplType(
 static HRESULT WINAPI ITypeInfo_fnGetImplTypeFlags( ITypeInfo2 *iface,
         UINT index, INT  *pImplTypeFlags)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
 
     TRACE("(%p) index %d\n", This, index);
 
@@ -6257,9 +6504,10 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
         LPOLESTR  *rgszNames, UINT cNames, MEMBERID  *pMemId)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    const TLBFuncDesc *pFDesc;
     const TLBVarDesc *pVDesc;
     HRESULT ret=S_OK;
-    UINT i, fdc;
+    UINT i;
 
     TRACE("%p, %s, %d.\n", iface, debugstr_w(*rgszNames), cNames);
 
@@ -6267,25 +6515,22 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
-    for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc) {
+    TLB_get_member_by_name(This, *rgszNames, &pFDesc, &pVDesc);
+    if(pFDesc) {
         int j;
-        const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
-        if(!lstrcmpiW(*rgszNames, TLB_get_bstr(pFDesc->Name))) {
-            if(cNames) *pMemId=pFDesc->funcdesc.memid;
-            for(i=1; i < cNames; i++){
-                for(j=0; j<pFDesc->funcdesc.cParams; j++)
-                    if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
-                            break;
-                if( j<pFDesc->funcdesc.cParams)
-                    pMemId[i]=j;
-                else
-                   ret=DISP_E_UNKNOWNNAME;
-            };
-            TRACE("-- %#lx.\n", ret);
-            return ret;
-        }
+        if(cNames) *pMemId=pFDesc->funcdesc.memid;
+        for(i=1; i < cNames; i++){
+            for(j=0; j<pFDesc->funcdesc.cParams; j++)
+                if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
+                        break;
+            if( j<pFDesc->funcdesc.cParams)
+                pMemId[i]=j;
+            else
+               ret=DISP_E_UNKNOWNNAME;
+        };
+        TRACE("-- %#lx.\n", ret);
+        return ret;
     }
-    pVDesc = TLB_get_vardesc_by_name(This, *rgszNames);
     if(pVDesc){
         if(cNames)
             *pMemId = pVDesc->vardesc.memid;
@@ -7166,6 +7411,75 @@ static inline BOOL func_restricted( const FUNCDESC *desc )
     return (desc->wFuncFlags & FUNCFLAG_FRESTRICTED) && (desc->memid >= 0);
 }
 
+static const TLBFuncDesc *TLB_get_funcdesc_for_invoke(ITypeInfoImpl *typeinfo, MEMBERID memid, UINT16 flags)
+{
+    TLBMemberIndex *index = TLB_get_member_index(typeinfo);
+    const TLBFuncDesc *func;
+    UINT i, lo, hi;
+
+    if (!index)
+    {
+        for (i = 0; i < typeinfo->typeattr.cFuncs; ++i)
+        {
+            func = &typeinfo->funcdescs[i];
+            if (memid == func->funcdesc.memid && (flags & func->funcdesc.invkind) &&
+                    !func_restricted(&func->funcdesc))
+                return func;
+        }
+        return NULL;
+    }
+
+    lo = 0;
+    hi = index->memid_count;
+    while (lo < hi)
+    {
+        UINT mid = (lo + hi) / 2;
+        if (index->memids[mid].memid < memid) lo = mid + 1;
+        else hi = mid;
+    }
+    for (i = lo; i < index->memid_count && index->memids[i].memid == memid; ++i)
+    {
+        func = &typeinfo->funcdescs[index->memids[i].index];
+        if ((flags & func->funcdesc.invkind) && !func_restricted(&func->funcdesc))
+            return func;
+    }
+    return NULL;
+}
+
+/* Fills in the variant types of the function params, which are cached once
+ * the typeinfo is laid out, since resolving user defined types is costly. */
+static HRESULT TLB_get_param_vts(ITypeInfoImpl *typeinfo, TLBFuncDesc *func, VARTYPE *vts)
+{
+    const FUNCDESC *func_desc = &func->funcdesc;
+    VARTYPE *cached;
+    HRESULT hr;
+    int i;
+
+    if (!func_desc->cParams) return S_OK;
+
+    if ((cached = func->param_vts))
+    {
+        memcpy(vts, cached, func_desc->cParams * sizeof(*vts));
+        return S_OK;
+    }
+
+    for (i = 0; i < func_desc->cParams; i++)
+    {
+        hr = typedescvt_to_variantvt((ITypeInfo *)&typeinfo->ITypeInfo2_iface,
+                &func_desc->lprgelemdescParam[i].tdesc, &vts[i]);
+        if (FAILED(hr))
+            return hr;
+    }
+
+    if (!typeinfo->needs_layout && (cached = malloc(func_desc->cParams * sizeof(*cached))))
+    {
+        memcpy(cached, vts, func_desc->cParams * sizeof(*cached));
+        if (InterlockedCompareExchangePointer((void **)&func->param_vts, cached, NULL))
+            free(cached);
+    }
+    return S_OK;
+}
+
 #define INVBUF_ELEMENT_SIZE \
     (sizeof(VARIANTARG) + sizeof(VARIANTARG) + sizeof(VARIANTARG *) + sizeof(VARTYPE))
 #define INVBUF_GET_ARG_ARRAY(buffer, params) (buffer)
@@ -7192,7 +7506,6 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
     TYPEKIND type_kind;
     HRESULT hres;
     const TLBFuncDesc *pFuncInfo;
-    UINT fdc;
 
     TRACE("%p, %p, %ld, %#x, %p, %p, %p, %p.\n", iface, pIUnk, memid, wFlags, pDispParams,
             pVarResult, pExcepInfo, pArgErr);
@@ -7217,15 +7530,9 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
 
     /* we do this instead of using GetFuncDesc since it will return a fake
      * FUNCDESC for dispinterfaces and we want the real function description */
-    for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc){
-        pFuncInfo = &This->funcdescs[fdc];
-        if ((memid == pFuncInfo->funcdesc.memid) &&
-            (wFlags & pFuncInfo->funcdesc.invkind) &&
-            !func_restricted( &pFuncInfo->funcdesc ))
-            break;
-    }
+    pFuncInfo = TLB_get_funcdesc_for_invoke(This, memid, wFlags);
 
-    if (fdc < This->typeattr.cFuncs) {
+    if (pFuncInfo) {
         const FUNCDESC *func_desc = &pFuncInfo->funcdesc;
 
         if (TRACE_ON(ole))
@@ -7268,13 +7575,9 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
                 goto func_fail;
             }
 
-            for (i = 0; i < func_desc->cParams; i++)
-            {
-                TYPEDESC *tdesc = &func_desc->lprgelemdescParam[i].tdesc;
-                hres = typedescvt_to_variantvt((ITypeInfo *)iface, tdesc, &rgvt[i]);
-                if (FAILED(hres))
-                    goto func_fail;
-            }
+            hres = TLB_get_param_vts(This, (TLBFuncDesc *)pFuncInfo, rgvt);
+            if (FAILED(hres))
+                goto func_fail;
 
             TRACE("changing args\n");
             for (i = 0; i < func_desc->cParams; i++)
@@ -7711,7 +8014,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDocumentation( ITypeInfo2 *iface,
         MEMBERID memid, BSTR  *pBstrName, BSTR  *pBstrDocString,
         DWORD  *pdwHelpContext, BSTR  *pBstrHelpFile)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
     const TLBFuncDesc *pFDesc;
     const TLBVarDesc *pVDesc;
     TRACE("%p, %ld, %p, %p, %p, %p.\n",
@@ -7727,6 +8030,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDocumentation( ITypeInfo2 *iface,
             *pBstrHelpFile=SysAllocString(TLB_get_bstr(This->pTypeLib->HelpFile));
         return S_OK;
     }else {/* for a member */
+        TLB_load_members(This);
         pFDesc = TLB_get_funcdesc_by_memberid(This, memid);
         if(pFDesc){
             if(pBstrName)
@@ -7880,6 +8184,7 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
 
         *pTypeInfoImpl = *This;
         pTypeInfoImpl->ref = 0;
+        pTypeInfoImpl->member_index = NULL;
         list_init(&pTypeInfoImpl->custdata_list);
 
         if (This->typeattr.typekind == TKIND_INTERFACE)
@@ -8142,7 +8447,7 @@ static HRESULT WINAPI ITypeInfo_fnGetMops( ITypeInfo2 *iface, MEMBERID memid, BS
 static HRESULT WINAPI ITypeInfo_fnGetContainingTypeLib( ITypeInfo2 *iface,
         ITypeLib  * *ppTLib, UINT  *pIndex)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
 
     /* If a pointer is null, we simply ignore it, the ATL in particular passes pIndex as 0 */
     if (pIndex) {
@@ -8167,7 +8472,7 @@ static HRESULT WINAPI ITypeInfo_fnGetContainingTypeLib( ITypeInfo2 *iface,
 static void WINAPI ITypeInfo_fnReleaseTypeAttr( ITypeInfo2 *iface,
         TYPEATTR* pTypeAttr)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
     TRACE("(%p)->(%p)\n", This, pTypeAttr);
     free(pTypeAttr);
 }
@@ -8213,7 +8518,7 @@ static void WINAPI ITypeInfo_fnReleaseVarDesc( ITypeInfo2 *iface,
 static HRESULT WINAPI ITypeInfo2_fnGetTypeKind( ITypeInfo2 * iface,
     TYPEKIND *pTypeKind)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
     *pTypeKind = This->typeattr.typekind;
     TRACE("(%p) type 0x%0x\n", This,*pTypeKind);
     return S_OK;
@@ -8228,7 +8533,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetTypeKind( ITypeInfo2 * iface,
  */
 static HRESULT WINAPI ITypeInfo2_fnGetTypeFlags( ITypeInfo2 *iface, ULONG *pTypeFlags)
 {
-    ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    ITypeInfoImpl *This = impl_from_ITypeInfo2_noload(iface);
     TRACE("%p, %p.\n", iface, pTypeFlags);
     *pTypeFlags=This->typeattr.wTypeFlags;
     return S_OK;
@@ -10160,9 +10465,11 @@ static HRESULT WINAPI ICreateTypeLib2_fnSaveAllChanges(ICreateTypeLib2 *iface)
 
     TRACE("%p\n", This);
 
-    for(i = 0; i < This->TypeInfoCount; ++i)
+    for(i = 0; i < This->TypeInfoCount; ++i){
+        TLB_load_members(This->typeinfos[i]);
         if(This->typeinfos[i]->needs_layout)
             ICreateTypeInfo2_LayOut(&This->typeinfos[i]->ICreateTypeInfo2_iface);
+    }
 
     memset(&file, 0, sizeof(file));
 
@@ -10766,6 +11073,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddFuncDesc(ICreateTypeInfo2 *iface,
     ++This->typeattr.cFuncs;
 
     This->needs_layout = TRUE;
+    TLB_free_member_index(This);
 
     return S_OK;
 }
@@ -10925,6 +11233,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddVarDesc(ICreateTypeInfo2 *iface,
     ++This->typeattr.cVars;
 
     This->needs_layout = TRUE;
+    TLB_free_member_index(This);
 
     return S_OK;
 }
@@ -10969,6 +11278,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncAndParamNames(ICreateTypeInfo2 *
         par_desc->Name = TLB_append_str(&This->pTypeLib->name_list, *(names + i));
     }
 
+    TLB_free_member_index(This);
     return S_OK;
 }
 
@@ -10986,6 +11296,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarName(ICreateTypeInfo2 *iface,
         return TYPE_E_ELEMENTNOTFOUND;
 
     This->vardescs[index].Name = TLB_append_str(&This->pTypeLib->name_list, name);
+    TLB_free_member_index(This);
     return S_OK;
 }
 
@@ -11272,6 +11583,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnDeleteFuncDesc(ICreateTypeInfo2 *iface,
     }
 
     This->needs_layout = TRUE;
+    TLB_free_member_index(This);
 
     return S_OK;
 }
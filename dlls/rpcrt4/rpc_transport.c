@@ -59,6 +59,8 @@ static RpcConnection *rpcrt4_spawn_connection(RpcConnection *old_connection);
 
 /**** ncacn_np support ****/
 
+struct ncalrpc_shm;
+
 typedef struct _RpcConnection_np
 {
     RpcConnection common;
@@ -68,8 +70,14 @@ typedef struct _RpcConnection_np
     IO_STATUS_BLOCK io_status;
     HANDLE event_cache;
     BOOL read_closed;
+    struct ncalrpc_shm *shm;
 } RpcConnection_np;
 
+static int rpcrt4_conn_np_read(RpcConnection *conn, void *buffer, unsigned int count);
+static int rpcrt4_conn_np_write(RpcConnection *conn, const void *buffer, unsigned int count);
+static RPC_STATUS ncalrpc_shm_connect(RpcConnection_np *npc);
+static void ncalrpc_shm_accept(RpcConnection_np *npc);
+
 static RpcConnection *rpcrt4_conn_np_alloc(void)
 {
   RpcConnection_np *npc = calloc(1, sizeof(RpcConnection_np));
@@ -198,6 +206,8 @@ static RPC_STATUS rpcrt4_ncalrpc_open(RpcConnection* Connection)
   pname = ncalrpc_pipe_name(Connection->Endpoint);
   r = rpcrt4_conn_open_pipe(Connection, pname, TRUE);
   I_RpcFree(pname);
+  if (r == RPC_S_OK)
+    r = ncalrpc_shm_connect(npc);
 
   return r;
 }
@@ -359,6 +369,7 @@ static RPC_STATUS rpcrt4_ncalrpc_handoff(RpcConnection *old_conn, RpcConnection
   TRACE("%s\n", old_conn->Endpoint);
 
   rpcrt4_conn_np_handoff((RpcConnection_np *)old_conn, (RpcConnection_np *)new_conn);
+  ncalrpc_shm_accept((RpcConnection_np *)new_conn);
   status = rpcrt4_conn_create_pipe(old_conn);
 
   /* Store the local computer name as the NetworkAddr for ncalrpc. */
@@ -468,6 +479,337 @@ static int rpcrt4_conn_np_wait_for_incoming_data(RpcConnection *conn)
     return rpcrt4_conn_np_read(conn, NULL, 0);
 }
 
+/**** ncalrpc shared memory channel ****/
+
+/* Once the pipe is connected, the server offers the client a section holding
+ * one ring buffer per direction, so that PDUs no longer go through wineserver.
+ * The pipe stays open for impersonation and client pid queries. */
+
+#define NCALRPC_SHM_MAGIC     0x4d485352  /* 'RSHM' */
+#define NCALRPC_SHM_RING_SIZE 0x10000     /* must be a power of 2 */
+#define NCALRPC_SHM_SPIN      4000
+
+struct ncalrpc_shm_offer
+{
+    DWORD   magic;
+    DWORD   ring_size;
+    ULONG64 section;         /* handle in the client process, 0 to keep using the pipe */
+    ULONG64 events[4];       /* data and space events of both rings, in the client process */
+};
+
+struct ncalrpc_ring
+{
+    LONG write_pos;          /* total number of bytes written */
+    LONG read_pos;           /* total number of bytes read */
+    LONG reader_waiting;     /* reader is waiting on the data event */
+    LONG writer_waiting;     /* writer is waiting on the space event */
+    LONG closed;             /* one side closed the connection */
+    LONG pad[11];
+};
+
+struct ncalrpc_shm
+{
+    HANDLE section;
+    HANDLE peer_process;     /* to notice the peer dying without closing the ring */
+    HANDLE events[4];        /* client to server data/space, server to client data/space */
+    char *view;
+    struct ncalrpc_ring *in, *out;
+    char *in_data, *out_data;
+    HANDLE in_data_event, in_space_event, out_data_event, out_space_event;
+    LONG read_cancelled;     /* the current read has been cancelled */
+    LONG write_cancelled;    /* the current write has been cancelled */
+};
+
+static void ncalrpc_shm_free(struct ncalrpc_shm *shm)
+{
+    unsigned int i;
+
+    if (shm->view) UnmapViewOfFile(shm->view);
+    if (shm->section) CloseHandle(shm->section);
+    if (shm->peer_process) CloseHandle(shm->peer_process);
+    for (i = 0; i < ARRAY_SIZE(shm->events); i++)
+        if (shm->events[i]) CloseHandle(shm->events[i]);
+    free(shm);
+}
+
+static BOOL ncalrpc_shm_map(struct ncalrpc_shm *shm, BOOL server)
+{
+    struct ncalrpc_ring *rings;
+
+    if (!(shm->view = MapViewOfFile(shm->section, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0)))
+        return FALSE;
+    rings = (struct ncalrpc_ring *)shm->view;
+    if (server)
+    {
+        shm->in = &rings[0];
+        shm->out = &rings[1];
+        shm->in_data = shm->view + 2 * sizeof(*rings);
+        shm->out_data = shm->in_data + NCALRPC_SHM_RING_SIZE;
+        shm->in_data_event = shm->events[0];
+        shm->in_space_event = shm->events[1];
+        shm->out_data_event = shm->events[2];
+        shm->out_space_event = shm->events[3];
+    }
+    else
+    {
+        shm->in = &rings[1];
+        shm->out = &rings[0];
+        shm->out_data = shm->view + 2 * sizeof(*rings);
+        shm->in_data = shm->out_data + NCALRPC_SHM_RING_SIZE;
+        shm->out_data_event = shm->events[0];
+        shm->out_space_event = shm->events[1];
+        shm->in_data_event = shm->events[2];
+        shm->in_space_event = shm->events[3];
+    }
+    return TRUE;
+}
+
+static void ncalrpc_shm_accept(RpcConnection_np *npc)
+{
+    struct ncalrpc_shm_offer offer = { NCALRPC_SHM_MAGIC, NCALRPC_SHM_RING_SIZE };
+    struct ncalrpc_shm *shm = NULL;
+    HANDLE process = GetCurrentProcess(), handle;
+    ULONG pid;
+    unsigned int i;
+
+    if (!(shm = calloc(1, sizeof(*shm)))) goto done;
+    if (!GetNamedPipeClientProcessId(npc->pipe, &pid) ||
+        !(shm->peer_process = OpenProcess(PROCESS_DUP_HANDLE | SYNCHRONIZE, FALSE, pid)))
+        goto failed;
+    if (!(shm->section = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+                                            2 * (sizeof(struct ncalrpc_ring) + NCALRPC_SHM_RING_SIZE), NULL)))
+        goto failed;
+    for (i = 0; i < ARRAY_SIZE(shm->events); i++)
+        if (!(shm->events[i] = CreateEventW(NULL, FALSE, FALSE, NULL))) goto failed;
+    if (!ncalrpc_shm_map(shm, TRUE)) goto failed;
+
+    if (!DuplicateHandle(process, shm->section, shm->peer_process, &handle, 0, FALSE, DUPLICATE_SAME_ACCESS))
+        goto failed;
+    offer.section = HandleToUlong(handle);
+    for (i = 0; i < ARRAY_SIZE(shm->events); i++)
+    {
+        if (!DuplicateHandle(process, shm->events[i], shm->peer_process, &handle, 0, FALSE, DUPLICATE_SAME_ACCESS))
+            goto failed;
+        offer.events[i] = HandleToUlong(handle);
+    }
+    npc->shm = shm;
+    goto done;
+
+failed:
+    WARN("using the pipe for ncalrpc, error %lu\n", GetLastError());
+    if (offer.section)
+    {
+        /* close what we already gave to the client */
+        DuplicateHandle(shm->peer_process, ULongToHandle(offer.section), NULL, NULL, 0, FALSE, DUPLICATE_CLOSE_SOURCE);
+        for (i = 0; i < ARRAY_SIZE(offer.events) && offer.events[i]; i++)
+            DuplicateHandle(shm->peer_process, ULongToHandle(offer.events[i]), NULL, NULL, 0, FALSE, DUPLICATE_CLOSE_SOURCE);
+        memset(&offer.section, 0, sizeof(offer) - offsetof(struct ncalrpc_shm_offer, section));
+    }
+    ncalrpc_shm_free(shm);
+done:
+    /* always answer, the client is waiting for it */
+    if (rpcrt4_conn_np_write(&npc->common, &offer, sizeof(offer)) != sizeof(offer))
+    {
+        if (npc->shm) ncalrpc_shm_free(npc->shm);
+        npc->shm = NULL;
+    }
+}
+
+static RPC_STATUS ncalrpc_shm_connect(RpcConnection_np *npc)
+{
+    struct ncalrpc_shm_offer offer;
+    struct ncalrpc_shm *shm;
+    ULONG pid;
+    unsigned int i;
+
+    if (rpcrt4_conn_np_read(&npc->common, &offer, sizeof(offer)) != sizeof(offer) ||
+        offer.magic != NCALRPC_SHM_MAGIC)
+    {
+        WARN("no channel offer from the server\n");
+        return RPC_S_PROTOCOL_ERROR;
+    }
+    if (!offer.section) return RPC_S_OK;
+
+    if (!(shm = calloc(1, sizeof(*shm)))) return RPC_S_OUT_OF_RESOURCES;
+    shm->section = ULongToHandle(offer.section);
+    for (i = 0; i < ARRAY_SIZE(shm->events); i++) shm->events[i] = ULongToHandle(offer.events[i]);
+
+    if (offer.ring_size != NCALRPC_SHM_RING_SIZE ||
+        !GetNamedPipeServerProcessId(npc->pipe, &pid) ||
+        !(shm->peer_process = OpenProcess(SYNCHRONIZE, FALSE, pid)) ||
+        !ncalrpc_shm_map(shm, FALSE))
+    {
+        /* the server notices through the ring being closed, or through our exit */
+        WARN("can't use the channel offered by the server\n");
+        if (shm->view)
+        {
+            InterlockedExchange(&shm->out->closed, 1);
+            InterlockedExchange(&shm->in->closed, 1);
+            SetEvent(shm->out_data_event);
+            SetEvent(shm->in_space_event);
+        }
+        ncalrpc_shm_free(shm);
+        return RPC_S_OUT_OF_RESOURCES;
+    }
+    npc->shm = shm;
+    return RPC_S_OK;
+}
+
+/* wait until the peer updated the given position, returns FALSE on failure */
+static BOOL ncalrpc_shm_wait(struct ncalrpc_shm *shm, LONG *pos, LONG old_pos, LONG *waiting, HANDLE event,
+                             LONG *cancelled)
+{
+    HANDLE handles[2] = { event, shm->peer_process };
+    unsigned int spin;
+
+    for (spin = 0; spin < NCALRPC_SHM_SPIN; spin++)
+    {
+        if (ReadNoFence(pos) != old_pos) return TRUE;
+        if (ReadNoFence(&shm->in->closed) || ReadNoFence(cancelled)) return FALSE;
+        YieldProcessor();
+    }
+
+    InterlockedExchange(waiting, 1);
+    while (ReadAcquire(pos) == old_pos && !ReadNoFence(&shm->in->closed) && !ReadNoFence(cancelled))
+    {
+        if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0) break;
+    }
+    InterlockedExchange(waiting, 0);
+    return ReadAcquire(pos) != old_pos;
+}
+
+static int ncalrpc_shm_read(RpcConnection_np *npc, void *buffer, unsigned int count)
+{
+    struct ncalrpc_shm *shm = npc->shm;
+    unsigned int done = 0, len, offset;
+    ULONG read_pos = shm->in->read_pos, write_pos;
+
+    InterlockedExchange(&shm->read_cancelled, 0);
+    while (done < count || !count)
+    {
+        if (npc->read_closed) return -1;
+        write_pos = ReadAcquire(&shm->in->write_pos);
+        if (write_pos == read_pos)
+        {
+            if (!ncalrpc_shm_wait(shm, &shm->in->write_pos, read_pos, &shm->in->reader_waiting,
+                                  shm->in_data_event, &shm->read_cancelled))
+                return -1;
+            continue;
+        }
+        if (!count) return 0;
+
+        len = min(count - done, write_pos - read_pos);
+        offset = read_pos & (NCALRPC_SHM_RING_SIZE - 1);
+        len = min(len, NCALRPC_SHM_RING_SIZE - offset);
+        memcpy((char *)buffer + done, shm->in_data + offset, len);
+        done += len;
+        read_pos += len;
+        InterlockedExchange(&shm->in->read_pos, read_pos);
+        if (ReadNoFence(&shm->in->writer_waiting)) SetEvent(shm->in_space_event);
+    }
+    return count;
+}
+
+static int ncalrpc_shm_write(RpcConnection_np *npc, const void *buffer, unsigned int count)
+{
+    struct ncalrpc_shm *shm = npc->shm;
+    unsigned int done = 0, len, offset;
+    ULONG write_pos = shm->out->write_pos, read_pos;
+
+    InterlockedExchange(&shm->write_cancelled, 0);
+    while (done < count)
+    {
+        if (ReadNoFence(&shm->out->closed)) return -1;
+        read_pos = ReadAcquire(&shm->out->read_pos);
+        if (write_pos - read_pos == NCALRPC_SHM_RING_SIZE)
+        {
+            if (!ncalrpc_shm_wait(shm, &shm->out->read_pos, read_pos, &shm->out->writer_waiting,
+                                  shm->out_space_event, &shm->write_cancelled))
+                return -1;
+            continue;
+        }
+
+        len = min(count - done, NCALRPC_SHM_RING_SIZE - (write_pos - read_pos));
+        offset = write_pos & (NCALRPC_SHM_RING_SIZE - 1);
+        len = min(len, NCALRPC_SHM_RING_SIZE - offset);
+        memcpy(shm->out_data + offset, (const char *)buffer + done, len);
+        done += len;
+        write_pos += len;
+        InterlockedExchange(&shm->out->write_pos, write_pos);
+        if (ReadNoFence(&shm->out->reader_waiting)) SetEvent(shm->out_data_event);
+    }
+    return count;
+}
+
+static void ncalrpc_shm_close(struct ncalrpc_shm *shm)
+{
+    InterlockedExchange(&shm->out->closed, 1);
+    InterlockedExchange(&shm->in->closed, 1);
+    SetEvent(shm->out_data_event);
+    SetEvent(shm->in_space_event);
+    ncalrpc_shm_free(shm);
+}
+
+static int rpcrt4_conn_ncalrpc_read(RpcConnection *conn, void *buffer, unsigned int count)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (npc->shm) return ncalrpc_shm_read(npc, buffer, count);
+    return rpcrt4_conn_np_read(conn, buffer, count);
+}
+
+static int rpcrt4_conn_ncalrpc_write(RpcConnection *conn, const void *buffer, unsigned int count)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (npc->shm) return ncalrpc_shm_write(npc, buffer, count);
+    return rpcrt4_conn_np_write(conn, buffer, count);
+}
+
+static int rpcrt4_conn_ncalrpc_close(RpcConnection *conn)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (npc->shm)
+    {
+        ncalrpc_shm_close(npc->shm);
+        npc->shm = NULL;
+    }
+    return rpcrt4_conn_np_close(conn);
+}
+
+static void rpcrt4_conn_ncalrpc_close_read(RpcConnection *conn)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (npc->shm)
+    {
+        npc->read_closed = TRUE;
+        InterlockedExchange(&npc->shm->read_cancelled, 1);
+        SetEvent(npc->shm->in_data_event);
+    }
+    else rpcrt4_conn_np_close_read(conn);
+}
+
+static void rpcrt4_conn_ncalrpc_cancel_call(RpcConnection *conn)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (npc->shm)
+    {
+        InterlockedExchange(&npc->shm->read_cancelled, 1);
+        InterlockedExchange(&npc->shm->write_cancelled, 1);
+        SetEvent(npc->shm->in_data_event);
+        SetEvent(npc->shm->out_space_event);
+    }
+    else rpcrt4_conn_np_cancel_call(conn);
+}
+
+static int rpcrt4_conn_ncalrpc_wait_for_incoming_data(RpcConnection *conn)
+{
+    return rpcrt4_conn_ncalrpc_read(conn, NULL, 0);
+}
+
 static size_t rpcrt4_ncacn_np_get_top_of_tower(unsigned char *tower_data,
                                                const char *networkaddr,
                                                const char *endpoint)
@@ -3145,13 +3487,13 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_alloc,
     rpcrt4_ncalrpc_open,
     rpcrt4_ncalrpc_handoff,
-    rpcrt4_conn_np_read,
-    rpcrt4_conn_np_write,
-    rpcrt4_conn_np_close,
-    rpcrt4_conn_np_close_read,
-    rpcrt4_conn_np_cancel_call,
+    rpcrt4_conn_ncalrpc_read,
+    rpcrt4_conn_ncalrpc_write,
+    rpcrt4_conn_ncalrpc_close,
+    rpcrt4_conn_ncalrpc_close_read,
+    rpcrt4_conn_ncalrpc_cancel_call,
     rpcrt4_ncalrpc_np_is_server_listening,
-    rpcrt4_conn_np_wait_for_incoming_data,
+    rpcrt4_conn_ncalrpc_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
     rpcrt4_ncalrpc_parse_top_of_tower,
     NULL,
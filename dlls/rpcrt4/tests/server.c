@@ -29,6 +29,7 @@
 #include "server.h"
 #define SKIP_TYPE_DECLS
 #include "server_interp.h"
+#include "server_inline.h"
 #include "server_defines.h"
 #include "explicit_handle.h"
 
@@ -260,6 +261,15 @@ static void set_interp_interface(void)
 #undef X
 }
 
+static void set_inline_interface(void)
+{
+    is_interp = FALSE;
+
+#define X(name) name = inline_##name;
+    SERVER_FUNCTIONS
+#undef X
+}
+
 static void set_mixed_interface(void)
 {
     is_interp = FALSE;
@@ -2164,6 +2174,20 @@ client(const char *test)
     ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
     ok(RPC_S_OK == RpcBindingFree(&IInterpServer_IfHandle), "RpcBindingFree\n");
   }
+  else if (strcmp(test, "np_basic_inline") == 0)
+  {
+    set_inline_interface();
+
+    ok(RPC_S_OK == RpcStringBindingComposeA(NULL, np, address_np, pipe, NULL, &binding), "RpcStringBindingCompose\n");
+    ok(RPC_S_OK == RpcBindingFromStringBindingA(binding, &IInlineServer_IfHandle), "RpcBindingFromStringBinding\n");
+
+    test_is_server_listening(IInlineServer_IfHandle, RPC_S_OK);
+    run_tests();
+    test_is_server_listening(IInlineServer_IfHandle, RPC_S_OK);
+
+    ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
+    ok(RPC_S_OK == RpcBindingFree(&IInlineServer_IfHandle), "RpcBindingFree\n");
+  }
   else if (strcmp(test, "explicit_handle") == 0)
   {
     IMixedServer_IfHandle = NULL;
@@ -2220,6 +2244,10 @@ server(void)
                                     RPC_IF_ALLOW_CALLBACKS_WITH_NO_AUTH,
                                     RPC_C_LISTEN_MAX_CALLS_DEFAULT, NULL);
     ok(status == RPC_S_OK, "RpcServerRegisterIfEx failed with status %ld\n", status);
+    status = pRpcServerRegisterIfEx(s_IInlineServer_v0_0_s_ifspec, NULL, NULL,
+                                    RPC_IF_ALLOW_CALLBACKS_WITH_NO_AUTH,
+                                    RPC_C_LISTEN_MAX_CALLS_DEFAULT, NULL);
+    ok(status == RPC_S_OK, "RpcServerRegisterIfEx failed with status %ld\n", status);
   }
   else
   {
@@ -2227,6 +2255,8 @@ server(void)
     ok(status == RPC_S_OK, "RpcServerRegisterIf failed with status %ld\n", status);
     status = RpcServerRegisterIf(s_IInterpServer_v0_0_s_ifspec, NULL, NULL);
     ok(status == RPC_S_OK, "RpcServerRegisterIf failed with status %ld\n", status);
+    status = RpcServerRegisterIf(s_IInlineServer_v0_0_s_ifspec, NULL, NULL);
+    ok(status == RPC_S_OK, "RpcServerRegisterIf failed with status %ld\n", status);
   }
   test_is_server_listening(NULL, RPC_S_NOT_LISTENING);
   status = RpcServerListen(1, RPC_C_LISTEN_MAX_CALLS_DEFAULT, TRUE);
@@ -2253,6 +2283,7 @@ server(void)
   if (np_status == RPC_S_OK)
   {
     run_client("np_basic_interp");
+    run_client("np_basic_inline");
     run_client("np_basic");
   }
   else
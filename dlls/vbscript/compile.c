@@ -1494,6 +1494,86 @@ static HRESULT fill_array_desc(compile_ctx_t *ctx, dim_decl_t *dim_decl, array_d
     return S_OK;
 }
 
+static BOOL lookup_local_slot(function_t *func, const WCHAR *name, unsigned *slot)
+{
+    unsigned i;
+
+    /* The function name refers to its return value, which is not a slot. */
+    if(!wcsicmp(name, func->name))
+        return FALSE;
+
+    for(i = 0; i < func->var_cnt; i++) {
+        if(!wcsicmp(func->vars[i].name, name)) {
+            *slot = i;
+            return TRUE;
+        }
+    }
+
+    for(i = 0; i < func->arg_cnt; i++) {
+        if(!wcsicmp(func->args[i].name, name)) {
+            *slot = func->var_cnt + i;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * Local variables and arguments take precedence over any other name in the
+ * function's scope, so references to them can be bound to their slots once
+ * the function is compiled instead of being looked up by name at run time.
+ */
+static void bind_local_identifiers(compile_ctx_t *ctx, function_t *func)
+{
+    instr_t *instr, *end = ctx->code->instrs + ctx->instr_cnt;
+    unsigned slot;
+
+    for(instr = ctx->code->instrs + func->code_off; instr < end; instr++) {
+        switch(instr->op) {
+        case OP_ident:
+            if(lookup_local_slot(func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_local;
+                instr->arg1.uint = slot;
+                instr->arg2.uint = 0;
+            }
+            break;
+        case OP_icall:
+            if(lookup_local_slot(func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_local;
+                instr->arg1.uint = slot;
+            }
+            break;
+        case OP_assign_ident:
+            if(lookup_local_slot(func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_assign_local;
+                instr->arg1.uint = slot;
+            }
+            break;
+        case OP_set_ident:
+            if(lookup_local_slot(func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_set_local;
+                instr->arg1.uint = slot;
+            }
+            break;
+        case OP_step:
+            if(lookup_local_slot(func, instr->arg2.bstr, &slot)) {
+                instr->op = OP_step_local;
+                instr->arg2.uint = slot;
+            }
+            break;
+        case OP_incc:
+            if(lookup_local_slot(func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_incc_local;
+                instr->arg1.uint = slot;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *func)
 {
     HRESULT hres;
@@ -1582,6 +1662,9 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
         assert(array_id == func->array_cnt);
     }
 
+    if(func->type != FUNC_GLOBAL)
+        bind_local_identifiers(ctx, func);
+
     return S_OK;
 }
 
@@ -809,6 +809,36 @@ static HRESULT interp_ident(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
+static inline VARIANT *get_local_var(exec_ctx_t *ctx, unsigned slot)
+{
+    if(slot < ctx->func->var_cnt)
+        return ctx->vars + slot;
+
+    assert(slot - ctx->func->var_cnt < ctx->func->arg_cnt);
+    return ctx->args + slot - ctx->func->var_cnt;
+}
+
+static HRESULT interp_local(exec_ctx_t *ctx)
+{
+    VARIANT *var = get_local_var(ctx, ctx->instr->arg1.uint);
+    const unsigned arg_cnt = ctx->instr->arg2.uint;
+    VARIANT v;
+    HRESULT hres;
+
+    TRACE("%u %u\n", ctx->instr->arg1.uint, arg_cnt);
+
+    if(arg_cnt) {
+        hres = variant_call(ctx, var, arg_cnt, &v);
+        if(FAILED(hres))
+            return hres;
+    }else {
+        V_VT(&v) = VT_BYREF|VT_VARIANT;
+        V_BYREF(&v) = V_VT(var) == (VT_VARIANT|VT_BYREF) ? V_VARIANTREF(var) : var;
+    }
+
+    return stack_push(ctx, &v);
+}
+
 static HRESULT assign_value(exec_ctx_t *ctx, VARIANT *dst, VARIANT *src, WORD flags)
 {
     VARIANT value;
@@ -835,63 +865,65 @@ static HRESULT assign_value(exec_ctx_t *ctx, VARIANT *dst, VARIANT *src, WORD fl
     return S_OK;
 }
 
-static HRESULT assign_ident(exec_ctx_t *ctx, BSTR name, WORD flags, DISPPARAMS *dp)
+static HRESULT assign_var(exec_ctx_t *ctx, VARIANT *v, WORD flags, DISPPARAMS *dp)
 {
-    ref_t ref;
     HRESULT hres;
 
-    hres = lookup_identifier(ctx, name, VBDISP_LET, &ref);
-    if(FAILED(hres))
-        return hres;
+    if(V_VT(v) == (VT_VARIANT|VT_BYREF))
+        v = V_VARIANTREF(v);
 
-    switch(ref.type) {
-    case REF_VAR: {
-        VARIANT *v = ref.u.v;
+    if(arg_cnt(dp)) {
+        SAFEARRAY *array;
 
-        if(V_VT(v) == (VT_VARIANT|VT_BYREF))
-            v = V_VARIANTREF(v);
+        if(V_VT(v) == VT_DISPATCH)
+            return disp_propput(ctx->script, V_DISPATCH(v), DISPID_VALUE, flags, dp);
 
-        if(arg_cnt(dp)) {
-            SAFEARRAY *array;
+        if(!(V_VT(v) & VT_ARRAY)) {
+            FIXME("array assign on type %d\n", V_VT(v));
+            return E_FAIL;
+        }
 
-            if(V_VT(v) == VT_DISPATCH) {
-                hres = disp_propput(ctx->script, V_DISPATCH(v), DISPID_VALUE, flags, dp);
-                break;
-            }
+        switch(V_VT(v)) {
+        case VT_ARRAY|VT_BYREF|VT_VARIANT:
+            array = *V_ARRAYREF(v);
+            break;
+        case VT_ARRAY|VT_VARIANT:
+            array = V_ARRAY(v);
+            break;
+        default:
+            FIXME("Unsupported array type %x\n", V_VT(v));
+            return E_NOTIMPL;
+        }
 
-            if(!(V_VT(v) & VT_ARRAY)) {
-                FIXME("array assign on type %d\n", V_VT(v));
-                return E_FAIL;
-            }
+        if(!array) {
+            FIXME("null array\n");
+            return E_FAIL;
+        }
 
-            switch(V_VT(v)) {
-            case VT_ARRAY|VT_BYREF|VT_VARIANT:
-                array = *V_ARRAYREF(v);
-                break;
-            case VT_ARRAY|VT_VARIANT:
-                array = V_ARRAY(v);
-                break;
-            default:
-                FIXME("Unsupported array type %x\n", V_VT(v));
-                return E_NOTIMPL;
-            }
+        hres = array_access(array, dp, &v);
+        if(FAILED(hres))
+            return hres;
+    }else if(V_VT(v) == (VT_ARRAY|VT_BYREF|VT_VARIANT)) {
+        FIXME("non-array assign\n");
+        return E_NOTIMPL;
+    }
 
-            if(!array) {
-                FIXME("null array\n");
-                return E_FAIL;
-            }
+    return assign_value(ctx, v, dp->rgvarg, flags);
+}
 
-            hres = array_access(array, dp, &v);
-            if(FAILED(hres))
-                return hres;
-        }else if(V_VT(v) == (VT_ARRAY|VT_BYREF|VT_VARIANT)) {
-            FIXME("non-array assign\n");
-            return E_NOTIMPL;
-        }
+static HRESULT assign_ident(exec_ctx_t *ctx, BSTR name, WORD flags, DISPPARAMS *dp)
+{
+    ref_t ref;
+    HRESULT hres;
 
-        hres = assign_value(ctx, v, dp->rgvarg, flags);
+    hres = lookup_identifier(ctx, name, VBDISP_LET, &ref);
+    if(FAILED(hres))
+        return hres;
+
+    switch(ref.type) {
+    case REF_VAR:
+        hres = assign_var(ctx, ref.u.v, flags, dp);
         break;
-    }
     case REF_DISP:
         hres = disp_propput(ctx->script, ref.u.d.disp, ref.u.d.id, flags, dp);
         break;
@@ -966,6 +998,46 @@ static HRESULT interp_set_ident(exec_ctx_t *ctx)
     return S_OK;
 }
 
+static HRESULT interp_assign_local(exec_ctx_t *ctx)
+{
+    const unsigned slot = ctx->instr->arg1.uint;
+    const unsigned arg_cnt = ctx->instr->arg2.uint;
+    DISPPARAMS dp;
+    HRESULT hres;
+
+    TRACE("%u %u\n", slot, arg_cnt);
+
+    vbstack_to_dp(ctx, arg_cnt, TRUE, &dp);
+    hres = assign_var(ctx, get_local_var(ctx, slot), DISPATCH_PROPERTYPUT, &dp);
+    if(FAILED(hres))
+        return hres;
+
+    stack_popn(ctx, arg_cnt+1);
+    return S_OK;
+}
+
+static HRESULT interp_set_local(exec_ctx_t *ctx)
+{
+    const unsigned slot = ctx->instr->arg1.uint;
+    const unsigned arg_cnt = ctx->instr->arg2.uint;
+    DISPPARAMS dp;
+    HRESULT hres;
+
+    TRACE("%u %u\n", slot, arg_cnt);
+
+    hres = stack_assume_disp(ctx, arg_cnt, NULL);
+    if(FAILED(hres))
+        return hres;
+
+    vbstack_to_dp(ctx, arg_cnt, TRUE, &dp);
+    hres = assign_var(ctx, get_local_var(ctx, slot), DISPATCH_PROPERTYPUTREF, &dp);
+    if(FAILED(hres))
+        return hres;
+
+    stack_popn(ctx, arg_cnt + 1);
+    return S_OK;
+}
+
 static HRESULT interp_assign_member(exec_ctx_t *ctx)
 {
     BSTR identifier = ctx->instr->arg1.bstr;
@@ -1420,16 +1492,12 @@ static HRESULT interp_redim_preserve(exec_ctx_t *ctx)
     return hres;
 }
 
-static HRESULT interp_step(exec_ctx_t *ctx)
+static HRESULT do_step(exec_ctx_t *ctx, VARIANT *var)
 {
-    const BSTR ident = ctx->instr->arg2.bstr;
     BOOL gteq_zero;
     VARIANT zero;
-    ref_t ref;
     HRESULT hres;
 
-    TRACE("%s\n", debugstr_w(ident));
-
     V_VT(&zero) = VT_I2;
     V_I2(&zero) = 0;
     hres = VarCmp(stack_top(ctx, 0), &zero, ctx->script->lcid, 0);
@@ -1438,16 +1506,7 @@ static HRESULT interp_step(exec_ctx_t *ctx)
 
     gteq_zero = hres == VARCMP_GT || hres == VARCMP_EQ;
 
-    hres = lookup_identifier(ctx, ident, VBDISP_ANY, &ref);
-    if(FAILED(hres))
-        return hres;
-
-    if(ref.type != REF_VAR) {
-        FIXME("%s is not REF_VAR\n", debugstr_w(ident));
-        return E_FAIL;
-    }
-
-    hres = VarCmp(ref.u.v, stack_top(ctx, 1), ctx->script->lcid, 0);
+    hres = VarCmp(var, stack_top(ctx, 1), ctx->script->lcid, 0);
     if(FAILED(hres))
         return hres;
 
@@ -1460,6 +1519,33 @@ static HRESULT interp_step(exec_ctx_t *ctx)
     return S_OK;
 }
 
+static HRESULT interp_step(exec_ctx_t *ctx)
+{
+    const BSTR ident = ctx->instr->arg2.bstr;
+    ref_t ref;
+    HRESULT hres;
+
+    TRACE("%s\n", debugstr_w(ident));
+
+    hres = lookup_identifier(ctx, ident, VBDISP_ANY, &ref);
+    if(FAILED(hres))
+        return hres;
+
+    if(ref.type != REF_VAR) {
+        FIXME("%s is not REF_VAR\n", debugstr_w(ident));
+        return E_FAIL;
+    }
+
+    return do_step(ctx, ref.u.v);
+}
+
+static HRESULT interp_step_local(exec_ctx_t *ctx)
+{
+    TRACE("%u\n", ctx->instr->arg2.uint);
+
+    return do_step(ctx, get_local_var(ctx, ctx->instr->arg2.uint));
+}
+
 static HRESULT interp_newenum(exec_ctx_t *ctx)
 {
     variant_val_t v;
@@ -2363,10 +2449,23 @@ static HRESULT interp_neg(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
+static HRESULT do_incc(exec_ctx_t *ctx, VARIANT *var)
+{
+    VARIANT v;
+    HRESULT hres;
+
+    hres = VarAdd(stack_top(ctx, 0), var, &v);
+    if(FAILED(hres))
+        return hres;
+
+    VariantClear(var);
+    *var = v;
+    return S_OK;
+}
+
 static HRESULT interp_incc(exec_ctx_t *ctx)
 {
     const BSTR ident = ctx->instr->arg1.bstr;
-    VARIANT v;
     ref_t ref;
     HRESULT hres;
 
@@ -2381,13 +2480,14 @@ static HRESULT interp_incc(exec_ctx_t *ctx)
         return E_FAIL;
     }
 
-    hres = VarAdd(stack_top(ctx, 0), ref.u.v, &v);
-    if(FAILED(hres))
-        return hres;
+    return do_incc(ctx, ref.u.v);
+}
 
-    VariantClear(ref.u.v);
-    *ref.u.v = v;
-    return S_OK;
+static HRESULT interp_incc_local(exec_ctx_t *ctx)
+{
+    TRACE("%u\n", ctx->instr->arg1.uint);
+
+    return do_incc(ctx, get_local_var(ctx, ctx->instr->arg1.uint));
 }
 
 static HRESULT interp_catch(exec_ctx_t *ctx)
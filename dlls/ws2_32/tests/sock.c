@@ -9855,6 +9855,23 @@ static void test_TransmitFile(void)
     ok(memcmp(buf, &footer_msg[0], sizeof(footer_msg)) == 0,
        "TransmitFile footer buffer did not match!\n");
 
+    /* Test TransmitFile with fewer bytes than the file contains */
+    SetFilePointer(file, 0, NULL, FILE_BEGIN);
+    bret = pTransmitFile(client, file, 20, 0, NULL, &buffers, 0);
+    ok(bret, "TransmitFile failed unexpectedly.\n");
+    iret = recv(dest, buf, sizeof(header_msg), 0);
+    ok(memcmp(buf, &header_msg[0], sizeof(header_msg)) == 0,
+       "TransmitFile header buffer did not match!\n");
+    iret = recv(dest, buf, 20, 0);
+    ok(iret == 20, "got %d\n", iret);
+    SetFilePointer(file, 0, NULL, FILE_BEGIN);
+    bret = ReadFile(file, buf + 20, 20, &num_bytes, NULL);
+    ok(bret && num_bytes == 20, "failed to read file, error %lu\n", GetLastError());
+    ok(!memcmp(buf, buf + 20, 20), "TransmitFile file data did not match!\n");
+    iret = recv(dest, buf, sizeof(footer_msg), 0);
+    ok(memcmp(buf, &footer_msg[0], sizeof(footer_msg)) == 0,
+       "TransmitFile footer buffer did not match!\n");
+
     /* Test overlapped TransmitFile */
     ov.hEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
     SetFilePointer(file, 0, NULL, FILE_BEGIN);
@@ -13140,6 +13157,89 @@ static void test_simultaneous_async_recv(void)
     for (i = 0; i < num_io; i++) CloseHandle(events[i]);
 }
 
+static void test_immediate_recv_send(void)
+{
+    char buffer[64], recvbuf[64];
+    OVERLAPPED overlapped = {0}, *povl;
+    SOCKET client, server;
+    DWORD size, flags = 0;
+    ULONG_PTR key;
+    HANDLE port;
+    WSABUF wsabuf;
+    int ret, i;
+
+    tcp_socketpair(&client, &server);
+    port = CreateIoCompletionPort((HANDLE)client, NULL, 123, 0);
+    ok(!!port, "failed to create port, error %lu\n", GetLastError());
+
+    /* data already queued completes synchronously and still posts a completion */
+    ret = send(server, "data", 5, 0);
+    ok(ret == 5, "got %d\n", ret);
+    Sleep(100);
+
+    wsabuf.buf = recvbuf;
+    wsabuf.len = sizeof(recvbuf);
+    size = 0xdeadbeef;
+    ret = WSARecv(client, &wsabuf, 1, &size, &flags, &overlapped, NULL);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ok(size == 5, "got size %lu\n", size);
+    ok(!strcmp(recvbuf, "data"), "got %s\n", debugstr_an(recvbuf, size));
+    ok(!overlapped.Internal, "got status %#Ix\n", overlapped.Internal);
+    ok(overlapped.InternalHigh == 5, "got size %Iu\n", overlapped.InternalHigh);
+
+    ret = GetQueuedCompletionStatus(port, &size, &key, &povl, 1000);
+    ok(ret, "got error %lu\n", GetLastError());
+    ok(size == 5, "got size %lu\n", size);
+    ok(key == 123, "got key %Iu\n", key);
+    ok(povl == &overlapped, "got overlapped %p\n", povl);
+
+    /* a pending receive is satisfied before a later one which finds data */
+    memset(recvbuf, 0, sizeof(recvbuf));
+    wsabuf.len = 4;
+    ret = WSARecv(client, &wsabuf, 1, NULL, &flags, &overlapped, NULL);
+    ok(ret == -1, "got %d\n", ret);
+    ok(WSAGetLastError() == ERROR_IO_PENDING, "got error %u\n", WSAGetLastError());
+
+    ret = send(server, "abcdefgh", 8, 0);
+    ok(ret == 8, "got %d\n", ret);
+
+    ret = recv(client, buffer, sizeof(buffer), 0);
+    ok(ret == 4, "got %d\n", ret);
+    ok(!memcmp(buffer, "efgh", 4), "got %s\n", debugstr_an(buffer, ret));
+
+    ret = GetQueuedCompletionStatus(port, &size, &key, &povl, 1000);
+    ok(ret, "got error %lu\n", GetLastError());
+    ok(size == 4, "got size %lu\n", size);
+    ok(!memcmp(recvbuf, "abcd", 4), "got %s\n", debugstr_an(recvbuf, 4));
+
+    /* many small messages keep their order */
+    for (i = 0; i < 1000; i++)
+    {
+        memset(buffer, i, sizeof(buffer));
+        ret = send(server, buffer, sizeof(buffer), 0);
+        ok(ret == sizeof(buffer), "got %d\n", ret);
+
+        size = 0;
+        while (size < sizeof(buffer))
+        {
+            ret = recv(client, recvbuf + size, sizeof(recvbuf) - size, 0);
+            if (ret <= 0) break;
+            size += ret;
+        }
+        ok(size == sizeof(buffer), "%d: got size %lu\n", i, size);
+        ok(!memcmp(buffer, recvbuf, sizeof(buffer)), "%d: data didn't match\n", i);
+        if (size != sizeof(buffer)) break;
+    }
+
+    ret = GetQueuedCompletionStatus(port, &size, &key, &povl, 0);
+    ok(!ret, "expected failure\n");
+    ok(GetLastError() == WAIT_TIMEOUT, "got error %lu\n", GetLastError());
+
+    closesocket(client);
+    closesocket(server);
+    CloseHandle(port);
+}
+
 static void test_empty_recv(void)
 {
     OVERLAPPED overlapped = {0};
@@ -14147,6 +14247,7 @@ START_TEST( sock )
     test_WSAGetOverlappedResult();
     test_nonblocking_async_recv();
     test_simultaneous_async_recv();
+    test_immediate_recv_send();
     test_empty_recv();
     test_timeout();
     test_tcp_reset();
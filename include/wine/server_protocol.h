@@ -1993,10 +1993,10 @@ struct get_mapping_info_reply
     mem_size_t   size;
     unsigned int flags;
     obj_handle_t shared_file;
+    obj_handle_t relocated_file;
     data_size_t  total;
     /* VARARG(image,pe_image_info); */
     /* VARARG(name,unicode_str); */
-    char __pad_28[4];
 };
 
 
@@ -2010,6 +2010,8 @@ struct get_image_map_address_reply
 {
     struct reply_header __header;
     client_ptr_t addr;
+    obj_handle_t relocated_file;
+    char __pad_20[4];
 };
 
 
@@ -5227,6 +5229,15 @@ struct add_completion_reply
 
 
 
+struct completion_info
+{
+    apc_param_t   ckey;
+    apc_param_t   cvalue;
+    apc_param_t   information;
+    unsigned int  status;
+    int           __pad;
+};
+
 struct remove_completion_request
 {
     struct request_header __header;
@@ -5235,11 +5246,7 @@ struct remove_completion_request
 struct remove_completion_reply
 {
     struct reply_header __header;
-    apc_param_t   ckey;
-    apc_param_t   cvalue;
-    apc_param_t   information;
-    unsigned int  status;
-    char __pad_36[4];
+    /* VARARG(msgs,completion_infos); */
 };
 
 
@@ -5277,6 +5284,8 @@ struct add_fd_completion_request
 {
     struct request_header __header;
     obj_handle_t   handle;
+    obj_handle_t   event;
+    char __pad_20[4];
     apc_param_t    cvalue;
     apc_param_t    information;
     unsigned int   status;
@@ -6507,7 +6516,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 786
+#define SERVER_PROTOCOL_VERSION 792
 
 /* ### protocol_version end ### */
 
@@ -213,24 +213,34 @@ DECL_HANDLER(add_completion)
 DECL_HANDLER(remove_completion)
 {
     struct completion* completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+    struct completion_info *info;
     struct list *entry;
     struct comp_msg *msg;
+    data_size_t count;
 
     if (!completion) return;
 
-    entry = list_head( &completion->queue );
-    if (!entry)
+    count = min( completion->depth, get_reply_max_size() / sizeof(*info) );
+    if (!list_head( &completion->queue ))
         set_error( STATUS_PENDING );
-    else
+    else if (!count)
+        set_error( STATUS_BUFFER_TOO_SMALL );
+    else if ((info = set_reply_data_size( count * sizeof(*info) )))
     {
-        list_remove( entry );
-        completion->depth--;
-        msg = LIST_ENTRY( entry, struct comp_msg, queue_entry );
-        reply->ckey = msg->ckey;
-        reply->cvalue = msg->cvalue;
-        reply->status = msg->status;
-        reply->information = msg->information;
-        free( msg );
+        while (count--)
+        {
+            entry = list_head( &completion->queue );
+            list_remove( entry );
+            completion->depth--;
+            msg = LIST_ENTRY( entry, struct comp_msg, queue_entry );
+            info->ckey = msg->ckey;
+            info->cvalue = msg->cvalue;
+            info->status = msg->status;
+            info->information = msg->information;
+            info->__pad = 0;
+            free( msg );
+            info++;
+        }
     }
 
     release_object( completion );
@@ -2929,7 +2929,16 @@ DECL_HANDLER(set_completion_info)
 /* push new completion msg into a completion queue attached to the fd */
 DECL_HANDLER(add_fd_completion)
 {
-    struct fd *fd = get_handle_fd_obj( current->process, req->handle, 0 );
+    struct fd *fd;
+    struct event *event;
+
+    if (req->event && (event = get_event_obj( current->process, req->event, EVENT_MODIFY_STATE )))
+    {
+        set_event( event );
+        release_object( event );
+    }
+
+    fd = get_handle_fd_obj( current->process, req->handle, 0 );
     if (fd)
     {
         if (fd->completion && (req->async || !(fd->comp_flags & FILE_SKIP_COMPLETION_PORT_ON_SUCCESS)))
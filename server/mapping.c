@@ -121,13 +121,61 @@ static const struct object_ops shared_map_ops =
 
 static struct list shared_map_list = LIST_INIT( shared_map_list );
 
+/* file holding a PE image already relocated to its dynamic base address */
+struct relocated_image
+{
+    struct object   obj;             /* object header */
+    struct fd      *fd;              /* file descriptor of the mapped PE file */
+    dev_t           dev;             /* device of the PE file */
+    ino_t           ino;             /* inode of the PE file */
+    off_t           size;            /* size of the PE file */
+    time_t          mtime;           /* modification time of the PE file */
+    client_ptr_t    base;            /* address the image is relocated to */
+    struct file    *file;            /* temp file holding the relocated image */
+    struct list     entry;           /* entry in global relocated images list */
+};
+
+static void relocated_image_dump( struct object *obj, int verbose );
+static void relocated_image_destroy( struct object *obj );
+
+static const struct object_ops relocated_image_ops =
+{
+    sizeof(struct relocated_image), /* size */
+    &no_type,                  /* type */
+    relocated_image_dump,      /* dump */
+    no_add_queue,              /* add_queue */
+    NULL,                      /* remove_queue */
+    NULL,                      /* signaled */
+    NULL,                      /* satisfied */
+    no_signal,                 /* signal */
+    no_get_fd,                 /* get_fd */
+    default_map_access,        /* map_access */
+    default_get_sd,            /* get_sd */
+    default_set_sd,            /* set_sd */
+    no_get_full_name,          /* get_full_name */
+    no_lookup_name,            /* lookup_name */
+    no_link_name,              /* link_name */
+    NULL,                      /* unlink_name */
+    no_open_file,              /* open_file */
+    no_kernel_obj_list,        /* get_kernel_obj_list */
+    no_close_handle,           /* close_handle */
+    relocated_image_destroy    /* destroy */
+};
+
+static struct list relocated_image_list = LIST_INIT( relocated_image_list );
+
+/* don't keep relocated copies of large images, building them blocks the server */
+static const mem_size_t max_relocated_image_size = 8 * 1024 * 1024;
+
 /* memory view mapped in client address space */
 struct memory_view
 {
     struct list     entry;           /* entry in per-process view list */
+    struct wine_rb_entry rb_entry;   /* entry in per-process view tree */
     struct fd      *fd;              /* fd for mapped file */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct relocated_image *relocated; /* temp file for relocated PE mapping */
     pe_image_info_t image;           /* image info (for PE image mapping) */
     unsigned int    flags;           /* SEC_* flags */
     client_ptr_t    base;            /* view base address (in process addr space) */
@@ -161,6 +209,7 @@ struct mapping
     pe_image_info_t image;           /* image info (for PE image mapping) */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct relocated_image *relocated; /* temp file for relocated PE mapping */
 };
 
 static void mapping_dump( struct object *obj, int verbose );
@@ -261,6 +310,22 @@ static void shared_map_destroy( struct object *obj )
     list_remove( &shared->entry );
 }
 
+static void relocated_image_dump( struct object *obj, int verbose )
+{
+    struct relocated_image *image = (struct relocated_image *)obj;
+    fprintf( stderr, "Relocated image fd=%p base=%08x%08x file=%p\n", image->fd,
+             (unsigned int)(image->base >> 32), (unsigned int)image->base, image->file );
+}
+
+static void relocated_image_destroy( struct object *obj )
+{
+    struct relocated_image *image = (struct relocated_image *)obj;
+
+    release_object( image->fd );
+    release_object( image->file );
+    list_remove( &image->entry );
+}
+
 /* extend a file beyond the current end of file */
 int grow_file( int unix_fd, file_pos_t new_size )
 {
@@ -355,13 +420,25 @@ static int create_temp_file( file_pos_t size )
     return fd;
 }
 
+/* compare an address against the range covered by a view */
+static int compare_view( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct memory_view *view = WINE_RB_ENTRY_VALUE( entry, struct memory_view, rb_entry );
+    client_ptr_t addr = *(const client_ptr_t *)key;
+
+    if (addr < view->base) return -1;
+    if (addr >= view->base + view->size) return 1;
+    return 0;
+}
+
 /* find a memory view from its base address */
 struct memory_view *find_mapped_view( struct process *process, client_ptr_t base )
 {
+    struct wine_rb_entry *entry = wine_rb_get( &process->view_tree, &base );
     struct memory_view *view;
 
-    LIST_FOR_EACH_ENTRY( view, &process->views, struct memory_view, entry )
-        if (view->base == base) return view;
+    if (entry && (view = WINE_RB_ENTRY_VALUE( entry, struct memory_view, rb_entry ))->base == base)
+        return view;
 
     set_error( STATUS_NOT_MAPPED_VIEW );
     return NULL;
@@ -370,10 +447,9 @@ struct memory_view *find_mapped_view( struct process *process, client_ptr_t base
 /* find a memory view from any address inside it */
 static struct memory_view *find_mapped_addr( struct process *process, client_ptr_t addr )
 {
-    struct memory_view *view;
+    struct wine_rb_entry *entry = wine_rb_get( &process->view_tree, &addr );
 
-    LIST_FOR_EACH_ENTRY( view, &process->views, struct memory_view, entry )
-        if (addr >= view->base && addr < view->base + view->size) return view;
+    if (entry) return WINE_RB_ENTRY_VALUE( entry, struct memory_view, rb_entry );
 
     set_error( STATUS_NOT_MAPPED_VIEW );
     return NULL;
@@ -382,18 +458,20 @@ static struct memory_view *find_mapped_addr( struct process *process, client_ptr
 /* check if an address range is valid for creating a view */
 static int is_valid_view_addr( struct process *process, client_ptr_t addr, mem_size_t size )
 {
-    struct memory_view *view;
+    struct wine_rb_entry *ptr = process->view_tree.root;
 
     if (!size) return 0;
     if (addr & page_mask) return 0;
     if (addr + size < addr) return 0;  /* overflow */
 
-    /* check for overlapping view */
-    LIST_FOR_EACH_ENTRY( view, &process->views, struct memory_view, entry )
+    /* check for overlapping view, views never overlap so a single descent is enough */
+    while (ptr)
     {
-        if (view->base + view->size <= addr) continue;
-        if (view->base >= addr + size) continue;
-        return 0;
+        struct memory_view *view = WINE_RB_ENTRY_VALUE( ptr, struct memory_view, rb_entry );
+
+        if (view->base >= addr + size) ptr = ptr->left;
+        else if (view->base + view->size <= addr) ptr = ptr->right;
+        else return 0;
     }
     return 1;
 }
@@ -436,6 +514,7 @@ static void add_process_view( struct thread *thread, struct memory_view *view )
             /* main exe */
             set_process_machine( process, view );
             list_add_head( &process->views, &view->entry );
+            wine_rb_put( &process->view_tree, &view->base, &view->rb_entry );
 
             free( process->image );
             process->image = NULL;
@@ -446,24 +525,34 @@ static void add_process_view( struct thread *thread, struct memory_view *view )
         }
     }
     list_add_tail( &process->views, &view->entry );
+    wine_rb_put( &process->view_tree, &view->base, &view->rb_entry );
 }
 
-static void free_memory_view( struct memory_view *view )
+static void free_memory_view( struct process *process, struct memory_view *view )
 {
     if (view->fd) release_object( view->fd );
     if (view->committed) release_object( view->committed );
     if (view->shared) release_object( view->shared );
+    if (view->relocated) release_object( view->relocated );
     list_remove( &view->entry );
+    wine_rb_remove( &process->view_tree, &view->rb_entry );
     free( view );
 }
 
+/* initialize the mapped views of a new process */
+void init_mapped_views( struct process *process )
+{
+    list_init( &process->views );
+    wine_rb_init( &process->view_tree, compare_view );
+}
+
 /* free all mapped views at process exit */
 void free_mapped_views( struct process *process )
 {
     struct list *ptr;
 
     while ((ptr = list_head( &process->views )))
-        free_memory_view( LIST_ENTRY( ptr, struct memory_view, entry ));
+        free_memory_view( process, LIST_ENTRY( ptr, struct memory_view, entry ));
 }
 
 /* find the shared PE mapping for a given mapping */
@@ -662,6 +751,210 @@ static int build_shared_mapping( struct mapping *mapping, int fd,
     return 0;
 }
 
+/* apply the base relocations of an image laid out in memory, fail on unsupported ones */
+static int apply_relocations( char *ptr, mem_size_t size, const IMAGE_DATA_DIRECTORY *dir,
+                              client_ptr_t delta )
+{
+    const IMAGE_BASE_RELOCATION *rel;
+    const unsigned short *reloc;
+    unsigned int count, offset;
+    mem_size_t pos, end;
+    unsigned short val16;
+    unsigned int val32;
+    unsigned __int64 val64;
+
+    if (dir->VirtualAddress >= size || dir->Size > size - dir->VirtualAddress) return 0;
+
+    pos = dir->VirtualAddress;
+    end = pos + dir->Size;
+    while (pos + sizeof(*rel) < end)
+    {
+        rel = (const IMAGE_BASE_RELOCATION *)(ptr + pos);
+        if (!rel->SizeOfBlock || rel->VirtualAddress >= size) break;
+        if (rel->SizeOfBlock < sizeof(*rel) || rel->SizeOfBlock > end - pos) return 0;
+
+        count = (rel->SizeOfBlock - sizeof(*rel)) / sizeof(*reloc);
+        reloc = (const unsigned short *)(rel + 1);
+        pos += sizeof(*rel) + count * sizeof(*reloc);
+        for ( ; count; count--, reloc++)
+        {
+            offset = rel->VirtualAddress + (*reloc & 0xfff);
+            switch (*reloc >> 12)
+            {
+            case IMAGE_REL_BASED_ABSOLUTE:
+                break;
+            case IMAGE_REL_BASED_HIGH:
+                if (offset + sizeof(val16) > size) return 0;
+                memcpy( &val16, ptr + offset, sizeof(val16) );
+                val16 += (unsigned short)(delta >> 16);
+                memcpy( ptr + offset, &val16, sizeof(val16) );
+                break;
+            case IMAGE_REL_BASED_LOW:
+                if (offset + sizeof(val16) > size) return 0;
+                memcpy( &val16, ptr + offset, sizeof(val16) );
+                val16 += (unsigned short)delta;
+                memcpy( ptr + offset, &val16, sizeof(val16) );
+                break;
+            case IMAGE_REL_BASED_HIGHLOW:
+                if (offset + sizeof(val32) > size) return 0;
+                memcpy( &val32, ptr + offset, sizeof(val32) );
+                val32 += (unsigned int)delta;
+                memcpy( ptr + offset, &val32, sizeof(val32) );
+                break;
+            case IMAGE_REL_BASED_DIR64:
+                if (offset + sizeof(val64) > size) return 0;
+                memcpy( &val64, ptr + offset, sizeof(val64) );
+                val64 += delta;
+                memcpy( ptr + offset, &val64, sizeof(val64) );
+                break;
+            default:
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* lay out a PE image the same way the client maps it, relocated to the given base */
+static struct file *build_relocated_image( struct mapping *mapping, client_ptr_t base )
+{
+    IMAGE_SECTION_HEADER sec[96];
+    IMAGE_DOS_HEADER *dos;
+    IMAGE_NT_HEADERS32 *nt32;
+    IMAGE_NT_HEADERS64 *nt64;
+    IMAGE_DATA_DIRECTORY *dir = NULL;
+    const IMAGE_SECTION_HEADER *first;
+    mem_size_t size = mapping->image.map_size;
+    size_t header_size, map_size, file_size;
+    unsigned int i, nb_sec;
+    off_t file_start;
+    struct file *file = NULL;
+    char *ptr;
+    int unix_fd, reloc_fd;
+
+    if ((unix_fd = get_unix_fd( mapping->fd )) == -1) return NULL;
+    if (!(ptr = calloc( 1, size ))) return NULL;
+
+    header_size = min( mapping->image.header_size, mapping->image.file_size );
+    if (header_size > size || pread( unix_fd, ptr, header_size, 0 ) != header_size) goto done;
+
+    dos = (IMAGE_DOS_HEADER *)ptr;
+    if (dos->e_lfanew + sizeof(*nt64) > header_size) goto done;
+    nt32 = (IMAGE_NT_HEADERS32 *)(ptr + dos->e_lfanew);
+    nt64 = (IMAGE_NT_HEADERS64 *)nt32;
+    nb_sec = nt32->FileHeader.NumberOfSections;
+    first = (const IMAGE_SECTION_HEADER *)((char *)&nt32->OptionalHeader + nt32->FileHeader.SizeOfOptionalHeader);
+    if (nb_sec > ARRAY_SIZE( sec ) || (char *)(first + nb_sec) > ptr + header_size) goto done;
+    memcpy( sec, first, nb_sec * sizeof(*sec) );
+
+    if (nt32->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC)
+    {
+        nt64->OptionalHeader.ImageBase = base;
+        if (nt64->OptionalHeader.NumberOfRvaAndSizes > IMAGE_DIRECTORY_ENTRY_BASERELOC)
+            dir = &nt64->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+    }
+    else
+    {
+        nt32->OptionalHeader.ImageBase = base;
+        if (nt32->OptionalHeader.NumberOfRvaAndSizes > IMAGE_DIRECTORY_ENTRY_BASERELOC)
+            dir = &nt32->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+    }
+
+    for (i = 0; i < nb_sec; i++)
+    {
+        get_section_sizes( &sec[i], &map_size, &file_start, &file_size );
+        if (!sec[i].PointerToRawData || !file_size) continue;
+        if (sec[i].VirtualAddress > size || file_size > size - sec[i].VirtualAddress) goto done;
+        if (pread( unix_fd, ptr + sec[i].VirtualAddress, file_size, file_start ) == -1) goto done;
+        if (file_size & page_mask)
+        {
+            size_t end = min( ROUND_SIZE( file_size ), map_size );
+            if (end > file_size && sec[i].VirtualAddress + end <= size)
+                memset( ptr + sec[i].VirtualAddress + file_size, 0, end - file_size );
+        }
+    }
+
+    if (dir && dir->Size && !apply_relocations( ptr, size, dir, base - mapping->image.base )) goto done;
+
+    if ((reloc_fd = create_temp_file( size )) == -1) goto done;
+    if (pwrite( reloc_fd, ptr, size, 0 ) != size)
+    {
+        close( reloc_fd );
+        goto done;
+    }
+    file = create_file_for_fd( reloc_fd, FILE_GENERIC_READ|FILE_GENERIC_WRITE, 0 );
+
+done:
+    free( ptr );
+    return file;
+}
+
+/* find or create the relocated copy of an image for a given base address */
+static struct relocated_image *get_relocated_image( struct mapping *mapping, client_ptr_t base )
+{
+    struct relocated_image *image;
+    struct file *file;
+    struct stat st;
+    int unix_fd;
+
+    if (mapping->relocated && mapping->relocated->base == base)
+        return (struct relocated_image *)grab_object( mapping->relocated );
+
+    if ((unix_fd = get_unix_fd( mapping->fd )) == -1 || fstat( unix_fd, &st ) == -1) return NULL;
+
+    LIST_FOR_EACH_ENTRY( image, &relocated_image_list, struct relocated_image, entry )
+    {
+        if (image->base == base && image->dev == st.st_dev && image->ino == st.st_ino &&
+            image->size == st.st_size && image->mtime == st.st_mtime)
+            return (struct relocated_image *)grab_object( image );
+    }
+
+    if (base == mapping->image.base) return NULL;
+    if (mapping->image.image_flags & IMAGE_FLAGS_ImageMappedFlat) return NULL;
+    /* writable shared sections are mapped from the shared file, unrelocated */
+    if (mapping->shared) return NULL;
+    /* ARM64X images get patched by the client depending on the process machine */
+    if (mapping->image.machine != IMAGE_FILE_MACHINE_I386 &&
+        mapping->image.machine != IMAGE_FILE_MACHINE_AMD64) return NULL;
+    if (mapping->image.map_size > max_relocated_image_size) return NULL;
+
+    if (!(file = build_relocated_image( mapping, base ))) return NULL;
+    if (!(image = alloc_object( &relocated_image_ops )))
+    {
+        release_object( file );
+        return NULL;
+    }
+    image->fd    = (struct fd *)grab_object( mapping->fd );
+    image->dev   = st.st_dev;
+    image->ino   = st.st_ino;
+    image->size  = st.st_size;
+    image->mtime = st.st_mtime;
+    image->base  = base;
+    image->file = file;
+    list_add_head( &relocated_image_list, &image->entry );
+    return image;
+}
+
+/* return a handle to the relocated copy of an image mapped at its assigned address */
+static obj_handle_t get_relocated_file( struct mapping *mapping )
+{
+    struct relocated_image *image;
+    obj_handle_t handle;
+
+    if (!mapping->image.map_addr) return 0;
+    if (!(mapping->image.image_charact & IMAGE_FILE_DLL)) return 0;
+    if (!(image = get_relocated_image( mapping, mapping->image.map_addr )))
+    {
+        clear_error();  /* the relocated image is optional */
+        return 0;
+    }
+
+    if (mapping->relocated) release_object( mapping->relocated );
+    mapping->relocated = image;
+    if (!(handle = alloc_handle( current->process, image->file, GENERIC_READ, 0 ))) clear_error();
+    return handle;
+}
+
 /* load the CLR header from its section */
 static int load_clr_header( IMAGE_COR20_HEADER *hdr, size_t va, size_t size, int unix_fd,
                             IMAGE_SECTION_HEADER *sec, unsigned int nb_sec )
@@ -945,6 +1238,7 @@ static struct mapping *create_mapping( struct object *root, const struct unicode
     mapping->size        = size;
     mapping->fd          = NULL;
     mapping->shared      = NULL;
+    mapping->relocated   = NULL;
     mapping->committed   = NULL;
 
     if (!(mapping->flags = get_mapping_flags( handle, flags ))) goto error;
@@ -1034,6 +1328,7 @@ struct mapping *create_fd_mapping( struct object *root, const struct unicode_str
     if (get_error() == STATUS_OBJECT_NAME_EXISTS) return mapping;  /* Nothing else to do */
 
     mapping->shared    = NULL;
+    mapping->relocated = NULL;
     mapping->committed = NULL;
     mapping->flags     = SEC_FILE;
     mapping->fd        = (struct fd *)grab_object( fd );
@@ -1146,6 +1441,7 @@ static void mapping_destroy( struct object *obj )
     if (mapping->fd) release_object( mapping->fd );
     if (mapping->committed) release_object( mapping->committed );
     if (mapping->shared) release_object( mapping->shared );
+    if (mapping->relocated) release_object( mapping->relocated );
 }
 
 static enum server_fd_type mapping_get_fd_type( struct fd *fd )
@@ -1309,6 +1605,9 @@ DECL_HANDLER(get_mapping_info)
     if (mapping->shared)
         reply->shared_file = alloc_handle( current->process, mapping->shared->file,
                                            GENERIC_READ|GENERIC_WRITE, 0 );
+    if ((mapping->flags & SEC_IMAGE) &&
+        (mapping->image.image_flags & IMAGE_FLAGS_ImageDynamicallyRelocated))
+        reply->relocated_file = get_relocated_file( mapping );
     release_object( mapping );
 }
 
@@ -1324,6 +1623,7 @@ DECL_HANDLER(get_image_map_address)
     {
         if (!mapping->image.map_addr) mapping->image.map_addr = assign_map_address( mapping );
         reply->addr = mapping->image.map_addr;
+        reply->relocated_file = get_relocated_file( mapping );
     }
     else set_error( STATUS_INVALID_PARAMETER );
 
@@ -1363,6 +1663,7 @@ DECL_HANDLER(map_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = mapping->committed ? (struct ranges *)grab_object( mapping->committed ) : NULL;
         view->shared    = NULL;
+        view->relocated = NULL;
         add_process_view( current, view );
     }
 
@@ -1400,6 +1701,10 @@ DECL_HANDLER(map_image_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = NULL;
         view->shared    = mapping->shared ? (struct shared_map *)grab_object( mapping->shared ) : NULL;
+        /* keep the relocated copy around for other processes loading the same image */
+        view->relocated = NULL;
+        if (mapping->relocated && mapping->relocated->base == req->base)
+            view->relocated = (struct relocated_image *)grab_object( mapping->relocated );
         view->image     = mapping->image;
         view->image.machine     = req->machine;
         view->image.entry_point = req->entry;
@@ -1454,7 +1759,7 @@ DECL_HANDLER(unmap_view)
 
     if (!view) return;
     generate_dll_event( current, DbgUnloadDllStateChange, view );
-    free_memory_view( view );
+    free_memory_view( current->process, view );
 }
 
 /* get information about a mapped image view */
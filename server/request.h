@@ -726,6 +726,7 @@ C_ASSERT( sizeof(rectangle_t) == 16 );
 C_ASSERT( sizeof(select_op_t) == 264 );
 C_ASSERT( sizeof(short int) == 2 );
 C_ASSERT( sizeof(startup_info_t) == 96 );
+C_ASSERT( sizeof(struct completion_info) == 32 );
 C_ASSERT( sizeof(struct filesystem_event) == 12 );
 C_ASSERT( sizeof(struct handle_info) == 20 );
 C_ASSERT( sizeof(struct luid) == 8 );
@@ -1143,12 +1144,14 @@ C_ASSERT( sizeof(struct get_mapping_info_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, size) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, flags) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, shared_file) == 20 );
-C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, total) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, relocated_file) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, total) == 28 );
 C_ASSERT( sizeof(struct get_mapping_info_reply) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_image_map_address_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_image_map_address_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_image_map_address_reply, addr) == 8 );
-C_ASSERT( sizeof(struct get_image_map_address_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_image_map_address_reply, relocated_file) == 16 );
+C_ASSERT( sizeof(struct get_image_map_address_reply) == 24 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, mapping) == 12 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, access) == 16 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, base) == 24 );
@@ -2218,11 +2221,7 @@ C_ASSERT( FIELD_OFFSET(struct add_completion_request, status) == 40 );
 C_ASSERT( sizeof(struct add_completion_request) == 48 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_request, handle) == 12 );
 C_ASSERT( sizeof(struct remove_completion_request) == 16 );
-C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, ckey) == 8 );
-C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, cvalue) == 16 );
-C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, information) == 24 );
-C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, status) == 32 );
-C_ASSERT( sizeof(struct remove_completion_reply) == 40 );
+C_ASSERT( sizeof(struct remove_completion_reply) == 8 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_request, handle) == 12 );
 C_ASSERT( sizeof(struct query_completion_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_reply, depth) == 8 );
@@ -2232,11 +2231,12 @@ C_ASSERT( FIELD_OFFSET(struct set_completion_info_request, ckey) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_completion_info_request, chandle) == 24 );
 C_ASSERT( sizeof(struct set_completion_info_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, handle) == 12 );
-C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, cvalue) == 16 );
-C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, information) == 24 );
-C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, status) == 32 );
-C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, async) == 36 );
-C_ASSERT( sizeof(struct add_fd_completion_request) == 40 );
+C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, event) == 16 );
+C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, cvalue) == 24 );
+C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, information) == 32 );
+C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, status) == 40 );
+C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, async) == 44 );
+C_ASSERT( sizeof(struct add_fd_completion_request) == 48 );
 C_ASSERT( FIELD_OFFSET(struct set_fd_completion_mode_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_fd_completion_mode_request, flags) == 16 );
 C_ASSERT( sizeof(struct set_fd_completion_mode_request) == 24 );
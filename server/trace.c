@@ -1383,6 +1383,25 @@ static void dump_varargs_handle_infos( const char *prefix, data_size_t size )
     fputc( '}', stderr );
 }
 
+static void dump_varargs_completion_infos( const char *prefix, data_size_t size )
+{
+    const struct completion_info *info;
+
+    fprintf( stderr, "%s{", prefix );
+    while (size >= sizeof(*info))
+    {
+        info = cur_data;
+        dump_uint64( "{ckey=", &info->ckey );
+        dump_uint64( ",cvalue=", &info->cvalue );
+        dump_uint64( ",information=", &info->information );
+        fprintf( stderr, ",status=%08x}", info->status );
+        size -= sizeof(*info);
+        remove_data( sizeof(*info) );
+        if (size) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+}
+
 typedef void (*dump_func)( const void *req );
 
 /* Everything below this line is generated automatically by tools/make_requests */
@@ -2194,6 +2213,7 @@ static void dump_get_mapping_info_reply( const struct get_mapping_info_reply *re
     dump_uint64( " size=", &req->size );
     fprintf( stderr, ", flags=%08x", req->flags );
     fprintf( stderr, ", shared_file=%04x", req->shared_file );
+    fprintf( stderr, ", relocated_file=%04x", req->relocated_file );
     fprintf( stderr, ", total=%u", req->total );
     dump_varargs_pe_image_info( ", image=", cur_size );
     dump_varargs_unicode_str( ", name=", cur_size );
@@ -2207,6 +2227,7 @@ static void dump_get_image_map_address_request( const struct get_image_map_addre
 static void dump_get_image_map_address_reply( const struct get_image_map_address_reply *req )
 {
     dump_uint64( " addr=", &req->addr );
+    fprintf( stderr, ", relocated_file=%04x", req->relocated_file );
 }
 
 static void dump_map_view_request( const struct map_view_request *req )
@@ -4371,10 +4392,7 @@ static void dump_remove_completion_request( const struct remove_completion_reque
 
 static void dump_remove_completion_reply( const struct remove_completion_reply *req )
 {
-    dump_uint64( " ckey=", &req->ckey );
-    dump_uint64( ", cvalue=", &req->cvalue );
-    dump_uint64( ", information=", &req->information );
-    fprintf( stderr, ", status=%08x", req->status );
+    dump_varargs_completion_infos( " msgs=", cur_size );
 }
 
 static void dump_query_completion_request( const struct query_completion_request *req )
@@ -4397,6 +4415,7 @@ static void dump_set_completion_info_request( const struct set_completion_info_r
 static void dump_add_fd_completion_request( const struct add_fd_completion_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", event=%04x", req->event );
     dump_uint64( ", cvalue=", &req->cvalue );
     dump_uint64( ", information=", &req->information );
     fprintf( stderr, ", status=%08x", req->status );
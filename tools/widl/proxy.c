@@ -905,6 +905,7 @@ static void write_proxy_routines(const statement_list_t *stmts)
   print_proxy( "#endif /* __RPCPROXY_H_VERSION__ */\n");
   print_proxy( "\n");
   print_proxy( "#include \"%s\"\n", header_name);
+  if (inline_marshal) print_proxy( "#include <string.h>\n");
   print_proxy( "\n");
 
   if (does_any_iface(stmts, need_proxy_and_inline_stubs))
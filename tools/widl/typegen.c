@@ -4043,6 +4043,15 @@ static void print_phase_function(FILE *file, int indent, const char *type,
     indent--;
 }
 
+static void print_buffer_align(FILE *file, int indent, enum remoting_phase phase, unsigned int alignment)
+{
+    if (alignment <= 1) return;
+    if (phase == PHASE_MARSHAL)
+        print_file(file, indent, "MIDL_memset(__frame->_StubMsg.Buffer, 0, (0x%x - (ULONG_PTR)__frame->_StubMsg.Buffer) & 0x%x);\n", alignment, alignment - 1);
+    print_file(file, indent, "__frame->_StubMsg.Buffer = (unsigned char *)(((ULONG_PTR)__frame->_StubMsg.Buffer + %u) & ~0x%x);\n",
+               alignment - 1, alignment - 1);
+}
+
 void print_phase_basetype(FILE *file, int indent, const char *local_var_prefix,
                           enum remoting_phase phase, enum pass pass, const var_t *var,
                           const char *varname)
@@ -4120,10 +4129,7 @@ void print_phase_basetype(FILE *file, int indent, const char *local_var_prefix,
                   var->name, get_basic_fc(ref->type));
         }
 
-        if (phase == PHASE_MARSHAL && alignment > 1)
-            print_file(file, indent, "MIDL_memset(__frame->_StubMsg.Buffer, 0, (0x%x - (ULONG_PTR)__frame->_StubMsg.Buffer) & 0x%x);\n", alignment, alignment - 1);
-        print_file(file, indent, "__frame->_StubMsg.Buffer = (unsigned char *)(((ULONG_PTR)__frame->_StubMsg.Buffer + %u) & ~0x%x);\n",
-                    alignment - 1, alignment - 1);
+        print_buffer_align(file, indent, phase, alignment);
 
         if (phase == PHASE_MARSHAL)
         {
@@ -4259,6 +4265,131 @@ void write_parameter_conf_or_var_exprs(FILE *file, int indent, const char *local
     }
 }
 
+/* wire size of a base type that is marshalled as a plain copy, 0 if it needs the NDR engine */
+static unsigned int get_flat_basetype_size(const type_t *type)
+{
+    if (typegen_detect_type(type, NULL, TDT_ALL_TYPES) != TGT_BASIC) return 0;
+
+    switch (get_basic_fc(type))
+    {
+    case FC_BYTE:
+    case FC_CHAR:
+    case FC_SMALL:
+    case FC_USMALL:
+        return 1;
+    case FC_WCHAR:
+    case FC_USHORT:
+    case FC_SHORT:
+        return 2;
+    case FC_ULONG:
+    case FC_LONG:
+    case FC_FLOAT:
+    case FC_ERROR_STATUS_T:
+        return 4;
+    case FC_INT3264:
+    case FC_UINT3264:
+        return pointer_size == 4 ? 4 : 0;
+    case FC_HYPER:
+    case FC_DOUBLE:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+static void print_raise_exception(FILE *file, int indent, const char *status)
+{
+    print_file(file, indent, "{\n");
+    print_file(file, indent + 1, "RpcRaiseException(%s);\n", status);
+    print_file(file, indent, "}\n");
+}
+
+/* same as NdrSimpleStruct{Marshall,Unmarshall} for a structure passed by reference */
+static void print_phase_simple_struct(FILE *file, int indent, const char *local_var_prefix,
+                                      enum remoting_phase phase, enum pass pass, const var_t *var)
+{
+    const decl_spec_t *ref = type_pointer_get_ref(var->declspec.type);
+    unsigned int size = type_memsize(ref->type);
+
+    print_buffer_align(file, indent, phase, type_buffer_alignment(ref->type));
+    if (phase == PHASE_MARSHAL)
+        print_file(file, indent, "memcpy(__frame->_StubMsg.Buffer, %s%s, %u);\n", local_var_prefix, var->name, size);
+    else
+    {
+        print_file(file, indent, "if (__frame->_StubMsg.Buffer + %u > __frame->_StubMsg.BufferEnd)\n", size);
+        print_raise_exception(file, indent, "RPC_X_BAD_STUB_DATA");
+        if (pass == PASS_IN)
+        {
+            /* the server points straight into the buffer */
+            print_file(file, indent, "%s%s = (", local_var_prefix, var->name);
+            write_type_decl(file, ref, NULL);
+            fprintf(file, " *)__frame->_StubMsg.Buffer;\n");
+        }
+        else
+            print_file(file, indent, "memcpy(%s%s, __frame->_StubMsg.Buffer, %u);\n", local_var_prefix, var->name, size);
+    }
+    print_file(file, indent, "__frame->_StubMsg.Buffer += %u;\n", size);
+}
+
+/* same as NdrConformantArray{BufferSize,Marshall,Unmarshall} for an [in] array of base types */
+static void print_phase_conformant_array(FILE *file, int indent, const char *local_var_prefix,
+                                         enum remoting_phase phase, const var_t *var)
+{
+    const decl_spec_t *elem = type_array_get_element(var->declspec.type);
+    unsigned int size = get_flat_basetype_size(elem->type);
+
+    switch (phase)
+    {
+    case PHASE_BUFFERSIZE:
+        print_file(file, indent, "if (__frame->_StubMsg.MaxCount > 0xffffffff / %u)\n", size);
+        print_raise_exception(file, indent, "RPC_S_INVALID_BOUND");
+        print_file(file, indent, "__frame->_StubMsg.BufferLength = ((__frame->_StubMsg.BufferLength + 3) & ~0x3) + 4;\n");
+        if (size > 1)
+            print_file(file, indent, "__frame->_StubMsg.BufferLength = (__frame->_StubMsg.BufferLength + %u) & ~0x%x;\n",
+                       size - 1, size - 1);
+        print_file(file, indent, "__frame->_StubMsg.BufferLength += (ULONG)__frame->_StubMsg.MaxCount * %u;\n", size);
+        break;
+    case PHASE_MARSHAL:
+        print_buffer_align(file, indent, phase, 4);
+        print_file(file, indent, "*(ULONG *)__frame->_StubMsg.Buffer = (ULONG)__frame->_StubMsg.MaxCount;\n");
+        print_file(file, indent, "__frame->_StubMsg.Buffer += 4;\n");
+        print_buffer_align(file, indent, phase, size);
+        print_file(file, indent, "memcpy(__frame->_StubMsg.Buffer, %s%s, (ULONG)__frame->_StubMsg.MaxCount * %u);\n",
+                   local_var_prefix, var->name, size);
+        print_file(file, indent, "__frame->_StubMsg.Buffer += (ULONG)__frame->_StubMsg.MaxCount * %u;\n", size);
+        break;
+    case PHASE_UNMARSHAL:
+        print_buffer_align(file, indent, phase, 4);
+        print_file(file, indent, "if (__frame->_StubMsg.Buffer + 4 > __frame->_StubMsg.BufferEnd)\n");
+        print_raise_exception(file, indent, "RPC_X_BAD_STUB_DATA");
+        print_file(file, indent, "__frame->_StubMsg.MaxCount = *(ULONG *)__frame->_StubMsg.Buffer;\n");
+        print_file(file, indent, "__frame->_StubMsg.Buffer += 4;\n");
+        print_buffer_align(file, indent, phase, size);
+        print_file(file, indent, "if (__frame->_StubMsg.Buffer > __frame->_StubMsg.BufferEnd ||\n");
+        print_file(file, indent, "    __frame->_StubMsg.MaxCount > (ULONG)(__frame->_StubMsg.BufferEnd - __frame->_StubMsg.Buffer) / %u)\n", size);
+        print_raise_exception(file, indent, "RPC_X_BAD_STUB_DATA");
+        /* the server points straight into the buffer */
+        print_file(file, indent, "%s%s = (", local_var_prefix, var->name);
+        write_type_decl(file, elem, NULL);
+        fprintf(file, " *)__frame->_StubMsg.Buffer;\n");
+        print_file(file, indent, "__frame->_StubMsg.Buffer += (ULONG)__frame->_StubMsg.MaxCount * %u;\n", size);
+        break;
+    case PHASE_FREE:
+        /* nothing to free for base types */
+        break;
+    }
+}
+
+/* whether an [in] conformant array of base types can be marshalled directly */
+static int is_inline_conformant_array(const type_t *type, int in_attr, int out_attr, int pointer_type)
+{
+    if (!inline_marshal || get_stub_mode() != MODE_Os) return 0;
+    if (!in_attr || out_attr || pointer_type != FC_RP) return 0;
+    if (get_array_fc(type) != FC_CARRAY) return 0;
+    if (type_array_get_conformance(type)->type == EXPR_VOID) return 0;
+    return get_flat_basetype_size(type_array_get_element_type(type)) != 0;
+}
+
 static void write_remoting_arg(FILE *file, int indent, const var_t *func, const char *local_var_prefix,
                                enum pass pass, enum remoting_phase phase, const var_t *var)
 {
@@ -4416,6 +4547,12 @@ static void write_remoting_arg(FILE *file, int indent, const var_t *func, const
 
         if (pointer_type != FC_RP) array_type = "Pointer";
 
+        if (is_inline_conformant_array(type, in_attr, out_attr, pointer_type))
+        {
+            print_phase_conformant_array(file, indent, local_var_prefix, phase, var);
+            break;
+        }
+
         if (phase == PHASE_FREE && pointer_type == FC_RP)
         {
             /* these are all unmarshalled by allocating memory */
@@ -4529,7 +4666,10 @@ static void write_remoting_arg(FILE *file, int indent, const var_t *func, const
                 /* simple structs have known sizes, so don't need a sizing
                  * pass and don't have any memory to free and so don't
                  * need a freeing pass */
-                if (phase == PHASE_MARSHAL || phase == PHASE_UNMARSHAL)
+                if ((phase == PHASE_MARSHAL || phase == PHASE_UNMARSHAL) &&
+                    inline_marshal && get_stub_mode() == MODE_Os && pass != PASS_RETURN)
+                    print_phase_simple_struct(file, indent, local_var_prefix, phase, pass, var);
+                else if (phase == PHASE_MARSHAL || phase == PHASE_UNMARSHAL)
                     type_str = "SimpleStruct";
                 else if (phase == PHASE_FREE && pass == PASS_RETURN)
                 {
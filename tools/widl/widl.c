@@ -52,6 +52,7 @@ static const char usage[] =
 "   -h                 Generate headers\n"
 "   -H file            Name of header file (default is infile.h)\n"
 "   -I directory       Add directory to the include search path (multiple -I allowed)\n"
+"   --inline-marshal   Marshal flat types directly in -Os stubs\n"
 "   -L directory       Add directory to the library search path (multiple -L allowed)\n"
 "   --local-stubs=file Write empty stubs for call_as/local methods to file\n"
 "   -m32, -m64         Set the target architecture (Win32 or Win64)\n"
@@ -106,6 +107,7 @@ int do_idfile = 0;
 int do_dlldata = 0;
 static int no_preprocess = 0;
 int old_names = 0;
+int inline_marshal = 0;
 int winrt_mode = 0;
 int use_abi_namespace = 0;
 static int stdinc = 1;
@@ -151,6 +153,7 @@ enum {
     APP_CONFIG_OPTION,
     DLLDATA_OPTION,
     DLLDATA_ONLY_OPTION,
+    INLINE_MARSHAL_OPTION,
     LOCAL_STUBS_OPTION,
     NOSTDINC_OPTION,
     PACKING_OPTION,
@@ -175,6 +178,7 @@ static const struct long_option long_options[] = {
     { "dlldata", 1, DLLDATA_OPTION },
     { "dlldata-only", 0, DLLDATA_ONLY_OPTION },
     { "help", 0, PRINT_HELP },
+    { "inline-marshal", 0, INLINE_MARSHAL_OPTION },
     { "local-stubs", 1, LOCAL_STUBS_OPTION },
     { "nostdinc", 0, NOSTDINC_OPTION },
     { "ns_prefix", 0, RT_NS_PREFIX },
@@ -492,6 +496,9 @@ static void option_callback( int optc, char *optarg )
       do_everything = 0;
       do_dlldata = 1;
       break;
+    case INLINE_MARSHAL_OPTION:
+      inline_marshal = 1;
+      break;
     case LOCAL_STUBS_OPTION:
       do_everything = 0;
       local_stubs_name = xstrdup(optarg);
@@ -46,6 +46,7 @@ extern int do_regscript;
 extern int do_idfile;
 extern int do_dlldata;
 extern int old_names;
+extern int inline_marshal;
 extern int winrt_mode;
 extern int use_abi_namespace;
 